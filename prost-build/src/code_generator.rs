@@ -19,6 +19,7 @@ use crate::extern_paths::ExternPaths;
 use crate::ident::{strip_enum_prefix, to_snake, to_upper_camel};
 use crate::message_graph::MessageGraph;
 use crate::Config;
+use crate::MapType;
 
 mod c_escaping;
 use c_escaping::unescape_c_escape_string;
@@ -65,6 +66,17 @@ impl Field {
     fn rust_name(&self) -> String {
         to_snake(self.descriptor.name())
     }
+
+    /// Returns the `name` attribute of the field, which gives its `.proto` name to field paths
+    /// when it differs from the Rust name, or an empty string.
+    fn name_attr(&self) -> String {
+        let name = self.descriptor.name();
+        if self.rust_name().trim_start_matches("r#") == name {
+            String::new()
+        } else {
+            format!(", name={:?}", name)
+        }
+    }
 }
 
 struct OneofField {
@@ -232,7 +244,7 @@ impl<'a> CodeGenerator<'a> {
             .push_str("#[allow(clippy::derive_partial_eq_without_eq)]\n");
         self.buf.push_str(&format!(
             "#[derive(Clone, {}PartialEq, {}::Message)]\n",
-            if self.message_graph.can_message_derive_copy(&fq_message_name) {
+            if self.can_message_derive_copy(&fq_message_name) {
                 "Copy, "
             } else {
                 ""
@@ -240,6 +252,7 @@ impl<'a> CodeGenerator<'a> {
             prost_path(self.config)
         ));
         self.append_skip_debug(&fq_message_name);
+        self.append_dyn_buf(&fq_message_name);
         self.push_indent();
         self.buf.push_str("pub struct ");
         self.buf.push_str(&to_upper_camel(&message_name));
@@ -270,10 +283,21 @@ impl<'a> CodeGenerator<'a> {
         }
         self.path.pop();
 
+        if self.cached_size(&fq_message_name) {
+            self.append_cached_size_field();
+        }
+        if self.preserve_unknown_fields(&fq_message_name) {
+            self.append_unknown_fields_field();
+        }
+
         self.depth -= 1;
         self.push_indent();
         self.buf.push_str("}\n");
 
+        if self.message_view(&fq_message_name) {
+            self.append_message_view(&message_name, &fq_message_name, &fields, &map_types);
+        }
+
         if !message.enum_type.is_empty() || !nested_types.is_empty() || !oneof_fields.is_empty() {
             self.push_mod(&message_name);
             self.path.push(3);
@@ -341,6 +365,10 @@ impl<'a> CodeGenerator<'a> {
             r#"fn full_name() -> {string_path} {{ "{full_name}".into() }}"#,
         ));
 
+        self.buf.push_str(&format!(
+            r#"const TYPE_URL: ::core::option::Option<&'static str> = ::core::option::Option::Some("{domain_name}/{full_name}");"#,
+        ));
+
         self.buf.push_str(&format!(
             r#"fn type_url() -> {string_path} {{ "{domain_name}/{full_name}".into() }}"#,
         ));
@@ -380,6 +408,15 @@ impl<'a> CodeGenerator<'a> {
         }
     }
 
+    fn append_dyn_buf(&mut self, fq_message_name: &str) {
+        assert_eq!(b'.', fq_message_name.as_bytes()[0]);
+        if self.config.dyn_buf.get(fq_message_name).next().is_some() {
+            push_indent(self.buf, self.depth);
+            self.buf.push_str("#[prost(dyn_buf)]");
+            self.buf.push('\n');
+        }
+    }
+
     fn append_enum_attributes(&mut self, fq_message_name: &str) {
         assert_eq!(b'.', fq_message_name.as_bytes()[0]);
         for attribute in self.config.enum_attributes.get(fq_message_name) {
@@ -408,6 +445,7 @@ impl<'a> CodeGenerator<'a> {
         let deprecated = self.deprecated(&field.descriptor);
         let optional = self.optional(&field.descriptor);
         let boxed = self.boxed(&field.descriptor, fq_message_name, None);
+        let lazy = self.lazy(fq_message_name, &field.descriptor);
         let ty = self.resolve_type(&field.descriptor, fq_message_name);
 
         debug!(
@@ -461,9 +499,13 @@ impl<'a> CodeGenerator<'a> {
             }
         }
 
+        if lazy {
+            self.buf.push_str(", lazy");
+        }
         if boxed {
             self.buf.push_str(", boxed");
         }
+        self.buf.push_str(&field.name_attr());
         self.buf.push_str(", tag=\"");
         self.buf.push_str(&field.descriptor.number().to_string());
 
@@ -513,6 +555,9 @@ impl<'a> CodeGenerator<'a> {
         } else if optional {
             self.buf.push_str("::core::option::Option<");
         }
+        if lazy {
+            self.buf.push_str(&format!("{}::Lazy<", prost_path));
+        }
         if boxed {
             self.buf
                 .push_str(&format!("{}::alloc::boxed::Box<", prost_path));
@@ -521,6 +566,9 @@ impl<'a> CodeGenerator<'a> {
         if boxed {
             self.buf.push('>');
         }
+        if lazy {
+            self.buf.push('>');
+        }
         if repeated || optional {
             self.buf.push('>');
         }
@@ -534,8 +582,8 @@ impl<'a> CodeGenerator<'a> {
         key: &FieldDescriptorProto,
         value: &FieldDescriptorProto,
     ) {
-        let key_ty = self.resolve_type(key, fq_message_name);
-        let value_ty = self.resolve_type(value, fq_message_name);
+        let key_ty = self.resolve_map_entry_type(key, fq_message_name, field.descriptor.name());
+        let value_ty = self.resolve_map_entry_type(value, fq_message_name, field.descriptor.name());
 
         debug!(
             "    map field: {:?}, key type: {:?}, value type: {:?}",
@@ -557,20 +605,31 @@ impl<'a> CodeGenerator<'a> {
         let value_tag = self.map_value_type_tag(value);
 
         self.buf.push_str(&format!(
-            "#[prost({}=\"{}, {}\", tag=\"{}\")]\n",
+            "#[prost({}=\"{}, {}\"{}, tag=\"{}\")]\n",
             map_type.annotation(),
             key_tag,
             value_tag,
+            field.name_attr(),
             field.descriptor.number()
         ));
         self.append_field_attributes(fq_message_name, field.descriptor.name());
         self.push_indent();
+        let hasher = match map_type {
+            MapType::HashMap => self
+                .config
+                .map_hasher
+                .get_first_field(fq_message_name, field.descriptor.name())
+                .map(|hasher| format!(", {}", hasher))
+                .unwrap_or_default(),
+            _ => String::new(),
+        };
         self.buf.push_str(&format!(
-            "pub {}: {}<{}, {}>,\n",
+            "pub {}: {}<{}, {}{}>,\n",
             field.rust_name(),
             map_type.rust_type(),
             key_ty,
-            value_ty
+            value_ty,
+            hasher
         ));
     }
 
@@ -605,6 +664,141 @@ impl<'a> CodeGenerator<'a> {
         ));
     }
 
+    fn append_cached_size_field(&mut self) {
+        self.push_indent();
+        self.buf.push_str("#[prost(cached_size)]\n");
+        self.push_indent();
+        self.buf.push_str(&format!(
+            "pub _cached_size: {}::CachedSize,\n",
+            prost_path(self.config)
+        ));
+    }
+
+    fn append_unknown_fields_field(&mut self) {
+        self.push_indent();
+        self.buf.push_str("#[prost(unknown_fields)]\n");
+        self.push_indent();
+        self.buf.push_str(&format!(
+            "pub _unknown_fields: {}::UnknownFields,\n",
+            prost_path(self.config)
+        ));
+    }
+
+    /// Appends the borrowed `MessageView` struct for a message.
+    ///
+    /// Map and group fields are skipped, oneof fields are never passed in.
+    fn append_message_view(
+        &mut self,
+        message_name: &str,
+        fq_message_name: &str,
+        fields: &[Field],
+        map_types: &HashMap<String, (FieldDescriptorProto, FieldDescriptorProto)>,
+    ) {
+        let prost_path = prost_path(self.config).to_owned();
+        let message_name = to_upper_camel(message_name);
+
+        self.push_indent();
+        self.buf.push_str(&format!(
+            "/// A borrowed view of [`{}`], decoded without copying strings or bytes.\n",
+            message_name
+        ));
+        self.push_indent();
+        self.buf
+            .push_str("#[allow(clippy::derive_partial_eq_without_eq)]\n");
+        self.push_indent();
+        self.buf.push_str(&format!(
+            "#[derive(Clone, PartialEq, Default, Debug, {}::MessageView)]\n",
+            prost_path
+        ));
+        self.push_indent();
+        self.buf
+            .push_str(&format!("pub struct {}View<'a> {{\n", message_name));
+        self.depth += 1;
+
+        let mut borrows = false;
+        for field in fields {
+            let descriptor = &field.descriptor;
+            let type_ = descriptor.r#type();
+            if type_ == Type::Group
+                || descriptor
+                    .type_name
+                    .as_ref()
+                    .map_or(false, |type_name| map_types.contains_key(type_name))
+            {
+                continue;
+            }
+
+            let repeated = descriptor.label() == Label::Repeated;
+            let optional = self.optional(descriptor);
+            let nested_view =
+                type_ == Type::Message && self.has_message_view(descriptor.type_name());
+            let boxed = nested_view && self.boxed(descriptor, fq_message_name, None);
+            let (type_tag, ty) = match type_ {
+                Type::String => (Cow::Borrowed("string"), "&'a str".to_owned()),
+                Type::Bytes => (Cow::Borrowed("bytes"), "&'a [u8]".to_owned()),
+                Type::Message if nested_view => (
+                    Cow::Borrowed("message"),
+                    format!("{}View<'a>", self.resolve_ident(descriptor.type_name())),
+                ),
+                // Messages without a view of their own are kept in their encoded form.
+                Type::Message => (Cow::Borrowed("bytes"), "&'a [u8]".to_owned()),
+                _ => (
+                    self.field_type_tag(descriptor),
+                    self.resolve_type(descriptor, fq_message_name),
+                ),
+            };
+            borrows |= matches!(type_, Type::String | Type::Bytes | Type::Message);
+
+            self.push_indent();
+            self.buf.push_str("#[prost(");
+            self.buf.push_str(&type_tag);
+            match descriptor.label() {
+                Label::Optional if optional => self.buf.push_str(", optional"),
+                Label::Optional => (),
+                Label::Required => self.buf.push_str(", required"),
+                Label::Repeated => self.buf.push_str(", repeated"),
+            }
+            if boxed {
+                self.buf.push_str(", boxed");
+            }
+            self.buf
+                .push_str(&format!(", tag=\"{}\")]\n", descriptor.number()));
+
+            self.push_indent();
+            self.buf.push_str("pub ");
+            self.buf.push_str(&field.rust_name());
+            self.buf.push_str(": ");
+            if repeated {
+                self.buf
+                    .push_str(&format!("{}::alloc::vec::Vec<", prost_path));
+            } else if optional {
+                self.buf.push_str("::core::option::Option<");
+            }
+            if boxed {
+                self.buf
+                    .push_str(&format!("{}::alloc::boxed::Box<", prost_path));
+            }
+            self.buf.push_str(&ty);
+            if boxed {
+                self.buf.push('>');
+            }
+            if repeated || optional {
+                self.buf.push('>');
+            }
+            self.buf.push_str(",\n");
+        }
+
+        if !borrows {
+            self.push_indent();
+            self.buf
+                .push_str("pub _marker: ::core::marker::PhantomData<&'a ()>,\n");
+        }
+
+        self.depth -= 1;
+        self.push_indent();
+        self.buf.push_str("}\n");
+    }
+
     fn append_oneof(&mut self, fq_message_name: &str, oneof: &OneofField) {
         self.path.push(8);
         self.path.push(oneof.path_index);
@@ -619,10 +813,10 @@ impl<'a> CodeGenerator<'a> {
         self.buf
             .push_str("#[allow(clippy::derive_partial_eq_without_eq)]\n");
 
-        let can_oneof_derive_copy = oneof.fields.iter().all(|field| {
-            self.message_graph
-                .can_field_derive_copy(fq_message_name, &field.descriptor)
-        });
+        let can_oneof_derive_copy = oneof
+            .fields
+            .iter()
+            .all(|field| self.can_field_derive_copy(fq_message_name, &field.descriptor));
         self.buf.push_str(&format!(
             "#[derive(Clone, {}PartialEq, {}::Oneof)]\n",
             if can_oneof_derive_copy { "Copy, " } else { "" },
@@ -961,7 +1155,21 @@ impl<'a> CodeGenerator<'a> {
             Type::Int32 | Type::Sfixed32 | Type::Sint32 | Type::Enum => String::from("i32"),
             Type::Int64 | Type::Sfixed64 | Type::Sint64 => String::from("i64"),
             Type::Bool => String::from("bool"),
-            Type::String => format!("{}::alloc::string::String", prost_path(self.config)),
+            Type::String
+                if self
+                    .config
+                    .intern_strings
+                    .get_first_field(fq_message_name, field.name())
+                    .is_some() =>
+            {
+                format!("{}::Interned", prost_path(self.config))
+            }
+            Type::String => self
+                .config
+                .string_type
+                .get_first_field(fq_message_name, field.name())
+                .cloned()
+                .unwrap_or_else(|| format!("{}::alloc::string::String", prost_path(self.config))),
             Type::Bytes => self
                 .config
                 .bytes_type
@@ -974,6 +1182,29 @@ impl<'a> CodeGenerator<'a> {
         }
     }
 
+    /// Returns the Rust type of the key or the value of the map field `map_field_name`. Unlike
+    /// other fields, string keys and values are `String` unless they are interned.
+    fn resolve_map_entry_type(
+        &self,
+        field: &FieldDescriptorProto,
+        fq_message_name: &str,
+        map_field_name: &str,
+    ) -> String {
+        match field.r#type() {
+            Type::String
+                if self
+                    .config
+                    .intern_strings
+                    .get_first_field(fq_message_name, map_field_name)
+                    .is_some() =>
+            {
+                format!("{}::Interned", prost_path(self.config))
+            }
+            Type::String => format!("{}::alloc::string::String", prost_path(self.config)),
+            _ => self.resolve_type(field, fq_message_name),
+        }
+    }
+
     fn resolve_ident(&self, pb_ident: &str) -> String {
         // protoc should always give fully qualified identifiers.
         assert_eq!(".", &pb_ident[..1]);
@@ -1106,6 +1337,92 @@ impl<'a> CodeGenerator<'a> {
         false
     }
 
+    /// Returns `true` if the message caches its encoded length.
+    fn cached_size(&self, fq_message_name: &str) -> bool {
+        assert_eq!(b'.', fq_message_name.as_bytes()[0]);
+        self.config
+            .cached_size
+            .get(fq_message_name)
+            .next()
+            .is_some()
+    }
+
+    /// Returns `true` if the message preserves its unknown fields.
+    fn preserve_unknown_fields(&self, fq_message_name: &str) -> bool {
+        assert_eq!(b'.', fq_message_name.as_bytes()[0]);
+        self.config
+            .preserve_unknown_fields
+            .get(fq_message_name)
+            .next()
+            .is_some()
+    }
+
+    /// Returns `true` if a `MessageView` is generated for the message.
+    fn message_view(&self, fq_message_name: &str) -> bool {
+        assert_eq!(b'.', fq_message_name.as_bytes()[0]);
+        self.config
+            .message_view
+            .get(fq_message_name)
+            .next()
+            .is_some()
+    }
+
+    /// Returns `true` if fields of the given message type can be represented by its
+    /// `MessageView`. External types never have a generated view.
+    fn has_message_view(&self, fq_message_name: &str) -> bool {
+        self.message_view(fq_message_name)
+            && self.extern_paths.resolve_ident(fq_message_name).is_none()
+    }
+
+    /// Returns `true` if the message field is decoded lazily.
+    fn lazy(&self, fq_message_name: &str, field: &FieldDescriptorProto) -> bool {
+        field.r#type() == Type::Message
+            && self
+                .config
+                .lazy
+                .get_first_field(fq_message_name, field.name())
+                .is_some()
+    }
+
+    /// Returns `true` if the message, or any message it contains by value, has a field which is
+    /// not `Copy` because of the configuration: a cached size, preserved unknown fields or a lazy
+    /// message field.
+    ///
+    /// Must only be called for messages without recursive fields.
+    fn contains_non_copy_field(&self, fq_message_name: &str) -> bool {
+        self.cached_size(fq_message_name)
+            || self.preserve_unknown_fields(fq_message_name)
+            || self
+                .message_graph
+                .get_message(fq_message_name)
+                .map_or(false, |message| {
+                    message.field.iter().any(|field| {
+                        field.r#type() == Type::Message
+                            && field.label() != Label::Repeated
+                            && (self.lazy(fq_message_name, field)
+                                || self.contains_non_copy_field(field.type_name()))
+                    })
+                })
+    }
+
+    /// Returns `true` if this message can automatically derive Copy trait.
+    ///
+    /// `CachedSize`, `UnknownFields` and `Lazy` are not `Copy`, so in addition to the message graph checks,
+    /// neither the message nor any message it contains may use them.
+    fn can_message_derive_copy(&self, fq_message_name: &str) -> bool {
+        self.message_graph.can_message_derive_copy(fq_message_name)
+            && !self.contains_non_copy_field(fq_message_name)
+    }
+
+    /// Returns `true` if the type of this field allows deriving the Copy trait.
+    fn can_field_derive_copy(&self, fq_message_name: &str, field: &FieldDescriptorProto) -> bool {
+        self.message_graph
+            .can_field_derive_copy(fq_message_name, field)
+            && (field.r#type() != Type::Message
+                || !(self.lazy(fq_message_name, field)
+                    || self.contains_non_copy_field(field.type_name())))
+    }
+
     /// Returns `true` if the field options includes the `deprecated` option.
     fn deprecated(&self, field: &FieldDescriptorProto) -> bool {
         field
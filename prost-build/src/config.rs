@@ -1,12 +1,18 @@
+use std::collections::hash_map::DefaultHasher;
 use std::collections::HashMap;
 use std::default;
 use std::env;
 use std::ffi::{OsStr, OsString};
 use std::fmt;
 use std::fs;
+use std::hash::{Hash, Hasher};
 use std::io::{Error, ErrorKind, Result, Write};
+#[cfg(feature = "format")]
+use std::num::NonZeroUsize;
 use std::path::{Path, PathBuf};
 use std::process::Command;
+#[cfg(feature = "format")]
+use std::thread;
 
 use log::debug;
 use log::trace;
@@ -28,14 +34,23 @@ use crate::ServiceGenerator;
 /// This configuration builder can be used to set non-default code generation options.
 pub struct Config {
     pub(crate) file_descriptor_set_path: Option<PathBuf>,
+    pub(crate) file_descriptor_set_cache: Option<PathBuf>,
     pub(crate) service_generator: Option<Box<dyn ServiceGenerator>>,
     pub(crate) map_type: PathMap<MapType>,
+    pub(crate) map_hasher: PathMap<String>,
     pub(crate) bytes_type: PathMap<BytesType>,
+    pub(crate) string_type: PathMap<String>,
+    pub(crate) intern_strings: PathMap<()>,
     pub(crate) type_attributes: PathMap<String>,
     pub(crate) message_attributes: PathMap<String>,
     pub(crate) enum_attributes: PathMap<String>,
     pub(crate) field_attributes: PathMap<String>,
     pub(crate) boxed: PathMap<()>,
+    pub(crate) cached_size: PathMap<()>,
+    pub(crate) preserve_unknown_fields: PathMap<()>,
+    pub(crate) message_view: PathMap<()>,
+    pub(crate) lazy: PathMap<()>,
+    pub(crate) dyn_buf: PathMap<()>,
     pub(crate) prost_types: bool,
     pub(crate) strip_enum_prefix: bool,
     pub(crate) out_dir: Option<PathBuf>,
@@ -120,6 +135,43 @@ impl Config {
         self
     }
 
+    /// Configure the code generator to generate Rust `HashMap` fields with a custom hasher for
+    /// Protobuf `map` type fields.
+    ///
+    /// The default hasher of `HashMap`, SipHash, resists collision attacks, but is slow for the
+    /// short keys maps usually have. Messages with many map entries decode and encode faster with
+    /// a faster hasher, such as the ones provided by the `ahash` or `rustc-hash` crates.
+    ///
+    /// # Arguments
+    ///
+    /// **`paths`** - paths to specific fields, messages, or packages whose Protobuf `map` fields
+    /// should use the hasher. It works the same way as in [`btree_map`](#method.btree_map). Map
+    /// fields which are generated as `BTreeMap` are not affected.
+    ///
+    /// **`hasher`** - the path of the Rust type implementing `BuildHasher` and `Default` to use,
+    /// which is used as the third type parameter of the `HashMap`.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// # let mut config = prost_build::Config::new();
+    /// // Use `ahash` for all map fields.
+    /// config.map_hasher(&["."], "::ahash::RandomState");
+    /// ```
+    pub fn map_hasher<I, S, H>(&mut self, paths: I, hasher: H) -> &mut Self
+    where
+        I: IntoIterator<Item = S>,
+        S: AsRef<str>,
+        H: AsRef<str>,
+    {
+        self.map_hasher.clear();
+        for matcher in paths {
+            self.map_hasher
+                .insert(matcher.as_ref().to_string(), hasher.as_ref().to_string());
+        }
+        self
+    }
+
     /// Configure the code generator to generate Rust [`bytes::Bytes`][1] fields for Protobuf
     /// [`bytes`][2] type fields.
     ///
@@ -181,6 +233,78 @@ impl Config {
         self
     }
 
+    /// Configure the code generator to generate fields of a custom Rust type for Protobuf
+    /// `string` type fields.
+    ///
+    /// `String` needs a heap allocation for every value. A string type with small-string
+    /// optimization, such as `compact_str::CompactString`, stores short values inline instead,
+    /// and `Arc<str>` values can be shared between messages without copying them.
+    ///
+    /// # Arguments
+    ///
+    /// **`paths`** - paths to specific fields, messages, or packages which should use the type
+    /// for Protobuf `string` fields. It works the same way as in [`btree_map`](#method.btree_map).
+    /// The keys and values of `map` fields are not affected.
+    ///
+    /// **`rust_type`** - the path of the Rust type to use. The type must implement
+    /// `prost::encoding::StringAdapter`, `Debug`, `Clone`, `PartialEq` and `From<&str>`, which
+    /// `prost` implements for `String`, `Box<str>` and `Arc<str>`.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// # let mut config = prost_build::Config::new();
+    /// // Use shared strings for all string fields in a message type.
+    /// config.string_type(&[".my_messages.MyMessageType"], "::std::sync::Arc<str>");
+    /// ```
+    pub fn string_type<I, S, T>(&mut self, paths: I, rust_type: T) -> &mut Self
+    where
+        I: IntoIterator<Item = S>,
+        S: AsRef<str>,
+        T: AsRef<str>,
+    {
+        self.string_type.clear();
+        for matcher in paths {
+            self.string_type
+                .insert(matcher.as_ref().to_string(), rust_type.as_ref().to_string());
+        }
+        self
+    }
+
+    /// Configure the code generator to generate interned `prost::Interned` fields for Protobuf
+    /// `string` type fields, including the keys and values of `map` fields.
+    ///
+    /// Interned fields decoded within `prost::with_interner` share a single copy of each
+    /// distinct value with the interner, instead of allocating a `String` for every value. This
+    /// saves memory and allocations when the values repeat often, such as the labels of log and
+    /// metric messages, and interned values are cheap to clone and compare. Fields matched by
+    /// both this option and [`string_type`](#method.string_type) are interned.
+    ///
+    /// # Arguments
+    ///
+    /// **`paths`** - paths to specific fields, messages, or packages whose Protobuf `string`
+    /// fields should be interned. It works the same way as in [`btree_map`](#method.btree_map).
+    /// A path matching a `map` field interns its string keys and values.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// # let mut config = prost_build::Config::new();
+    /// // Intern the labels of a metric message.
+    /// config.intern_strings(&[".my_metrics.Point.labels", ".my_metrics.Point.name"]);
+    /// ```
+    pub fn intern_strings<I, S>(&mut self, paths: I) -> &mut Self
+    where
+        I: IntoIterator<Item = S>,
+        S: AsRef<str>,
+    {
+        self.intern_strings.clear();
+        for matcher in paths {
+            self.intern_strings.insert(matcher.as_ref().to_string(), ());
+        }
+        self
+    }
+
     /// Add additional attribute to matched fields.
     ///
     /// # Arguments
@@ -372,6 +496,212 @@ impl Config {
         self
     }
 
+    /// Configure the code generator to cache the encoded length of matched messages.
+    ///
+    /// Each matched message gets an additional `_cached_size` field of type
+    /// [`prost::CachedSize`][1]. Sizing the message stores its encoded length there, so that
+    /// encoding a tree of nested messages sizes every message once, instead of once per level of
+    /// nesting. This helps deeply nested messages the most; for flat messages the extra field is
+    /// pure overhead.
+    ///
+    /// Messages with a cached size do not derive `Copy`, and neither do messages containing them.
+    ///
+    /// # Arguments
+    ///
+    /// **`paths`** - paths to specific messages or packages which should cache their encoded
+    /// length. It works the same way as in [`btree_map`](#method.btree_map), just with the field
+    /// name omitted.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// # let mut config = prost_build::Config::new();
+    /// // Cache the encoded length of a specific message.
+    /// config.cached_size(&[".my_messages.MyMessageType"]);
+    ///
+    /// // Cache the encoded length of all messages in a package.
+    /// config.cached_size(&[".my_messages"]);
+    /// ```
+    ///
+    /// [1]: https://docs.rs/prost/latest/prost/struct.CachedSize.html
+    pub fn cached_size<I, S>(&mut self, paths: I) -> &mut Self
+    where
+        I: IntoIterator<Item = S>,
+        S: AsRef<str>,
+    {
+        self.cached_size.clear();
+        for matcher in paths {
+            self.cached_size.insert(matcher.as_ref().to_string(), ());
+        }
+        self
+    }
+
+    /// Configure the code generator to preserve the unknown fields of matched messages.
+    ///
+    /// By default, fields which are not part of a message's definition are skipped when the
+    /// message is decoded, so a message which is decoded and encoded again by code built from an
+    /// older schema loses them. Each matched message instead gets an additional `_unknown_fields`
+    /// field of type [`prost::UnknownFields`][1], which stores the encoded unknown fields when the
+    /// message is decoded, and writes them back after the known fields when it is encoded.
+    ///
+    /// Unknown fields are not parsed: when decoding from a `Bytes` buffer, they are stored as
+    /// slices of it, without copying. Messages which preserve unknown fields do not derive `Copy`,
+    /// and neither do messages containing them.
+    ///
+    /// # Arguments
+    ///
+    /// **`paths`** - paths to specific messages or packages which should preserve their unknown
+    /// fields. It works the same way as in [`btree_map`](#method.btree_map), just with the field
+    /// name omitted.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// # let mut config = prost_build::Config::new();
+    /// // Preserve the unknown fields of a specific message.
+    /// config.preserve_unknown_fields(&[".my_messages.MyMessageType"]);
+    ///
+    /// // Preserve the unknown fields of all messages in a package.
+    /// config.preserve_unknown_fields(&[".my_messages"]);
+    /// ```
+    ///
+    /// [1]: https://docs.rs/prost/latest/prost/struct.UnknownFields.html
+    pub fn preserve_unknown_fields<I, S>(&mut self, paths: I) -> &mut Self
+    where
+        I: IntoIterator<Item = S>,
+        S: AsRef<str>,
+    {
+        self.preserve_unknown_fields.clear();
+        for matcher in paths {
+            self.preserve_unknown_fields
+                .insert(matcher.as_ref().to_string(), ());
+        }
+        self
+    }
+
+    /// Configure the code generator to generate borrowed views of matched messages.
+    ///
+    /// Alongside each matched message `Foo`, a `FooView<'a>` struct is generated which implements
+    /// [`prost::MessageView`][1]. A view decodes directly from an input `&'a [u8]`, representing
+    /// `string` fields as `&'a str` and `bytes` fields as `&'a [u8]`, so decoding it does not copy
+    /// or allocate string and bytes data. This suits code which only inspects a few fields of a
+    /// message before passing the encoded bytes on.
+    ///
+    /// Message fields whose type also has a view are represented by the nested view. Message
+    /// fields of any other type are represented by their raw encoded bytes, which can be decoded
+    /// separately when needed. Map, oneof and group fields are not part of the view, and are
+    /// skipped while decoding it. Protobuf `default` values are not applied to view fields.
+    ///
+    /// # Arguments
+    ///
+    /// **`paths`** - paths to specific messages or packages which should get a view. It works the
+    /// same way as in [`btree_map`](#method.btree_map), just with the field name omitted.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// # let mut config = prost_build::Config::new();
+    /// // Generate a view of a specific message.
+    /// config.message_view(&[".my_messages.MyMessageType"]);
+    ///
+    /// // Generate views of all messages in a package.
+    /// config.message_view(&[".my_messages"]);
+    /// ```
+    ///
+    /// [1]: https://docs.rs/prost/latest/prost/trait.MessageView.html
+    pub fn message_view<I, S>(&mut self, paths: I) -> &mut Self
+    where
+        I: IntoIterator<Item = S>,
+        S: AsRef<str>,
+    {
+        self.message_view.clear();
+        for matcher in paths {
+            self.message_view.insert(matcher.as_ref().to_string(), ());
+        }
+        self
+    }
+
+    /// Configure the code generator to decode matched message fields lazily.
+    ///
+    /// Matched fields are wrapped in [`prost::Lazy`][1], which keeps the encoded bytes of the
+    /// nested message when the outer message is decoded. The nested message is decoded on first
+    /// access, and a field which is never accessed is encoded again by copying the original bytes.
+    /// This saves decoding and re-encoding sub-messages which are only passed through. Decoding
+    /// from a `Bytes` buffer keeps the encoded bytes zero-copy.
+    ///
+    /// Only singular and repeated message fields can be lazy; the option has no effect on other
+    /// fields, and on map or oneof fields. Messages with lazy fields do not derive `Copy`.
+    ///
+    /// # Arguments
+    ///
+    /// **`paths`** - paths to specific fields, messages, or packages which should be decoded
+    /// lazily. For details about matching fields see [`btree_map`](#method.btree_map).
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// # let mut config = prost_build::Config::new();
+    /// // Decode a specific field lazily.
+    /// config.lazy(&[".my_messages.MyMessageType.payload"]);
+    ///
+    /// // Decode all message fields of a message lazily.
+    /// config.lazy(&[".my_messages.MyMessageType"]);
+    /// ```
+    ///
+    /// [1]: https://docs.rs/prost/latest/prost/struct.Lazy.html
+    pub fn lazy<I, S>(&mut self, paths: I) -> &mut Self
+    where
+        I: IntoIterator<Item = S>,
+        S: AsRef<str>,
+    {
+        self.lazy.clear();
+        for matcher in paths {
+            self.lazy.insert(matcher.as_ref().to_string(), ());
+        }
+        self
+    }
+
+    /// Configure the code generator to generate non-generic encoding and decoding code for matched
+    /// messages.
+    ///
+    /// The `Message` methods which take a buffer are generic over the buffer type, so the
+    /// encoding and decoding code of every message is compiled again for every buffer type it is
+    /// used with. Matched messages get `#[prost(dyn_buf)]`, which compiles this code once, for
+    /// `dyn Buf` and `dyn DynBufMut`, behind thin generic methods which convert the buffer to a
+    /// trait object. This reduces code size and compile times for large schemas, at the cost of a
+    /// dynamic call for every buffer access.
+    ///
+    /// Nested messages which are also matched are decoded and encoded through the same trait
+    /// object, so it is best to match whole packages.
+    ///
+    /// # Arguments
+    ///
+    /// **`paths`** - paths to specific messages or packages which should get non-generic code.
+    /// It works the same way as in [`btree_map`](#method.btree_map), just with the field name
+    /// omitted.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// # let mut config = prost_build::Config::new();
+    /// // Generate non-generic code for a specific message.
+    /// config.dyn_buf(&[".my_messages.MyMessageType"]);
+    ///
+    /// // Generate non-generic code for all messages.
+    /// config.dyn_buf(&["."]);
+    /// ```
+    pub fn dyn_buf<I, S>(&mut self, paths: I) -> &mut Self
+    where
+        I: IntoIterator<Item = S>,
+        S: AsRef<str>,
+    {
+        self.dyn_buf.clear();
+        for matcher in paths {
+            self.dyn_buf.insert(matcher.as_ref().to_string(), ());
+        }
+        self
+    }
+
     /// Configures the code generator to use the provided service generator.
     pub fn service_generator(&mut self, service_generator: Box<dyn ServiceGenerator>) -> &mut Self {
         self.service_generator = Some(service_generator);
@@ -579,6 +909,34 @@ impl Config {
         self
     }
 
+    /// When set, the `FileDescriptorSet` generated by `protoc` is cached in the provided file,
+    /// and `protoc` is only run again when its inputs change.
+    ///
+    /// The cache records a hash of the `protoc` path, the include paths, the `protoc` arguments,
+    /// the `.proto` files to compile and the contents of every file in the descriptor set,
+    /// including imported files. When none of them changed since the cache was written, the
+    /// cached descriptor set is compiled without running `protoc`. Files which `protoc` finds
+    /// outside of the include paths, such as the well-known types bundled with it, are not
+    /// checked for changes.
+    ///
+    /// The cache is typically placed in `OUT_DIR`, where it survives until the build directory is
+    /// cleaned.
+    ///
+    /// ```rust, no_run
+    /// # use std::env;
+    /// # use std::path::PathBuf;
+    /// # let mut config = prost_build::Config::new();
+    /// config.file_descriptor_set_cache(
+    ///     PathBuf::from(env::var("OUT_DIR").unwrap()).join("file_descriptor_set.cache"));
+    /// ```
+    pub fn file_descriptor_set_cache<P>(&mut self, path: P) -> &mut Self
+    where
+        P: Into<PathBuf>,
+    {
+        self.file_descriptor_set_cache = Some(path.into());
+        self
+    }
+
     /// In combination with with `file_descriptor_set_path`, this can be used to provide a file
     /// descriptor set as an input file, rather than having prost-build generate the file by calling
     /// protoc.
@@ -858,6 +1216,15 @@ impl Config {
         // this figured out.
         // [1]: http://doc.crates.io/build-script.html#outputs-of-the-build-script
 
+        if !self.skip_protoc_run {
+            if let Some(buf) = self.read_file_descriptor_set_cache(protos, includes)? {
+                if let Some(path) = &self.file_descriptor_set_path {
+                    write_file_if_changed(path, &buf)?;
+                }
+                return self.compile_fds(decode_file_descriptor_set(&buf)?);
+            }
+        }
+
         let tmp;
         let file_descriptor_set_path = if let Some(path) = &self.file_descriptor_set_path {
             path.clone()
@@ -937,16 +1304,90 @@ impl Config {
                 ),
             )
         })?;
-        let file_descriptor_set = FileDescriptorSet::decode(buf.as_slice()).map_err(|error| {
-            Error::new(
-                ErrorKind::InvalidInput,
-                format!("invalid FileDescriptorSet: {}", error),
-            )
-        })?;
+        let file_descriptor_set = decode_file_descriptor_set(&buf)?;
+
+        if !self.skip_protoc_run {
+            if let Some(cache) = &self.file_descriptor_set_cache {
+                let hash = self.protoc_inputs_hash(protos, includes, &file_descriptor_set);
+                let mut content = hash.to_le_bytes().to_vec();
+                content.extend_from_slice(&buf);
+                write_file_if_changed(cache, &content)?;
+            }
+        }
 
         self.compile_fds(file_descriptor_set)
     }
 
+    /// Returns the cached `FileDescriptorSet`, if there is one and the inputs of `protoc` have not
+    /// changed since it was cached.
+    ///
+    /// The cache holds the hash of the inputs, as a little-endian `u64`, followed by the encoded
+    /// `FileDescriptorSet`.
+    fn read_file_descriptor_set_cache(
+        &self,
+        protos: &[impl AsRef<Path>],
+        includes: &[impl AsRef<Path>],
+    ) -> Result<Option<Vec<u8>>> {
+        let cache = match &self.file_descriptor_set_cache {
+            Some(cache) => cache,
+            None => return Ok(None),
+        };
+        let content = match fs::read(cache) {
+            Ok(content) if content.len() >= 8 => content,
+            Ok(_) => return Ok(None),
+            Err(err) if err.kind() == ErrorKind::NotFound => return Ok(None),
+            Err(err) => return Err(err),
+        };
+
+        let (hash, buf) = content.split_at(8);
+        let file_descriptor_set = match FileDescriptorSet::decode(buf) {
+            Ok(file_descriptor_set) => file_descriptor_set,
+            Err(_) => return Ok(None),
+        };
+        if hash
+            != self
+                .protoc_inputs_hash(protos, includes, &file_descriptor_set)
+                .to_le_bytes()
+        {
+            debug!("protoc inputs changed, ignoring {}", cache.display());
+            return Ok(None);
+        }
+
+        trace!("using cached file descriptor set: {:?}", cache);
+        Ok(Some(buf.to_vec()))
+    }
+
+    /// Returns a hash of the inputs of the `protoc` run which generated the `FileDescriptorSet`.
+    fn protoc_inputs_hash(
+        &self,
+        protos: &[impl AsRef<Path>],
+        includes: &[impl AsRef<Path>],
+        file_descriptor_set: &FileDescriptorSet,
+    ) -> u64 {
+        let mut include_paths = includes
+            .iter()
+            .map(|include| include.as_ref().to_owned())
+            .collect::<Vec<_>>();
+        include_paths.extend(protoc_include_from_env());
+
+        let mut hasher = DefaultHasher::new();
+        protoc_from_env().hash(&mut hasher);
+        include_paths.hash(&mut hasher);
+        self.protoc_args.hash(&mut hasher);
+        for proto in protos {
+            proto.as_ref().hash(&mut hasher);
+        }
+        for file in &file_descriptor_set.file {
+            // protoc resolves imports in the include paths, in order.
+            let content = include_paths
+                .iter()
+                .find_map(|include| fs::read(include.join(file.name())).ok());
+            file.name().hash(&mut hasher);
+            content.hash(&mut hasher);
+        }
+        hasher.finish()
+    }
+
     pub(crate) fn write_includes(
         &self,
         mut modules: Vec<&Module>,
@@ -1044,11 +1485,7 @@ impl Config {
 
         #[cfg(feature = "format")]
         if self.fmt {
-            for buf in modules.values_mut() {
-                let file = syn::parse_file(buf).unwrap();
-                let formatted = prettyplease::unparse(&file);
-                *buf = formatted;
-            }
+            format_modules(modules.values_mut().collect());
         }
 
         self.add_generated_modules(&mut modules);
@@ -1064,6 +1501,40 @@ impl Config {
     }
 }
 
+/// Formats the generated code of the modules with `prettyplease`, on all available cores.
+#[cfg(feature = "format")]
+fn format_modules(mut bufs: Vec<&mut String>) {
+    fn format(buf: &mut String) {
+        let file = syn::parse_file(buf).unwrap();
+        *buf = prettyplease::unparse(&file);
+    }
+
+    let threads = thread::available_parallelism()
+        .map_or(1, NonZeroUsize::get)
+        .min(bufs.len());
+    if threads <= 1 {
+        bufs.into_iter().for_each(format);
+        return;
+    }
+
+    let chunk_len = (bufs.len() + threads - 1) / threads;
+    thread::scope(|scope| {
+        for chunk in bufs.chunks_mut(chunk_len) {
+            scope.spawn(move || chunk.iter_mut().for_each(|buf| format(buf)));
+        }
+    });
+}
+
+/// Decodes the `FileDescriptorSet` generated by `protoc`.
+fn decode_file_descriptor_set(buf: &[u8]) -> Result<FileDescriptorSet> {
+    FileDescriptorSet::decode(buf).map_err(|error| {
+        Error::new(
+            ErrorKind::InvalidInput,
+            format!("invalid FileDescriptorSet: {}", error),
+        )
+    })
+}
+
 /// Write a slice as the entire contents of a file.
 ///
 /// This function will create a file if it does not exist,
@@ -1088,14 +1559,23 @@ impl default::Default for Config {
     fn default() -> Config {
         Config {
             file_descriptor_set_path: None,
+            file_descriptor_set_cache: None,
             service_generator: None,
             map_type: PathMap::default(),
+            map_hasher: PathMap::default(),
             bytes_type: PathMap::default(),
+            string_type: PathMap::default(),
+            intern_strings: PathMap::default(),
             type_attributes: PathMap::default(),
             message_attributes: PathMap::default(),
             enum_attributes: PathMap::default(),
             field_attributes: PathMap::default(),
             boxed: PathMap::default(),
+            cached_size: PathMap::default(),
+            preserve_unknown_fields: PathMap::default(),
+            message_view: PathMap::default(),
+            lazy: PathMap::default(),
+            dyn_buf: PathMap::default(),
             prost_types: true,
             strip_enum_prefix: true,
             out_dir: None,
@@ -1119,11 +1599,20 @@ impl fmt::Debug for Config {
     fn fmt(&self, fmt: &mut fmt::Formatter<'_>) -> fmt::Result {
         fmt.debug_struct("Config")
             .field("file_descriptor_set_path", &self.file_descriptor_set_path)
+            .field("file_descriptor_set_cache", &self.file_descriptor_set_cache)
             .field("service_generator", &self.service_generator.is_some())
             .field("map_type", &self.map_type)
+            .field("map_hasher", &self.map_hasher)
             .field("bytes_type", &self.bytes_type)
+            .field("string_type", &self.string_type)
+            .field("intern_strings", &self.intern_strings)
             .field("type_attributes", &self.type_attributes)
             .field("field_attributes", &self.field_attributes)
+            .field("cached_size", &self.cached_size)
+            .field("preserve_unknown_fields", &self.preserve_unknown_fields)
+            .field("message_view", &self.message_view)
+            .field("lazy", &self.lazy)
+            .field("dyn_buf", &self.dyn_buf)
             .field("prost_types", &self.prost_types)
             .field("strip_enum_prefix", &self.strip_enum_prefix)
             .field("out_dir", &self.out_dir)
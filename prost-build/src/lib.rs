@@ -282,6 +282,8 @@ mod tests {
     use std::io::Read;
     use std::rc::Rc;
 
+    use prost::Message;
+
     use super::*;
 
     /// An example service generator that generates a trait with methods corresponding to the
@@ -528,6 +530,61 @@ mod tests {
         }
     }
 
+    #[test]
+    fn file_descriptor_set_cache() {
+        let _ = env_logger::try_init();
+        let tempdir = tempfile::tempdir().unwrap();
+        let protos = tempdir.path().join("protos");
+        std::fs::create_dir(&protos).unwrap();
+        for file in ["hello.proto", "types.proto"] {
+            std::fs::copy(
+                Path::new("src/fixtures/helloworld").join(file),
+                protos.join(file),
+            )
+            .unwrap();
+        }
+        let cache = tempdir.path().join("file_descriptor_set.cache");
+        let out_file = tempdir.path().join("helloworld.rs");
+        let compile = || {
+            Config::new()
+                .file_descriptor_set_cache(&cache)
+                .out_dir(tempdir.path())
+                .compile_protos(&[protos.join("hello.proto")], &[&protos])
+                .unwrap();
+        };
+
+        compile();
+        assert!(read_all_content(&out_file).contains("pub struct Message {"));
+
+        // Replace the cached descriptor set, to check that it is used instead of running protoc.
+        let content = std::fs::read(&cache).unwrap();
+        let (hash, buf) = content.split_at(8);
+        let mut file_descriptor_set = FileDescriptorSet::decode(buf).unwrap();
+        for file in &mut file_descriptor_set.file {
+            for message in &mut file.message_type {
+                if message.name() == "Message" {
+                    message.name = Some("CachedMessage".to_string());
+                }
+            }
+        }
+        let mut content = hash.to_vec();
+        file_descriptor_set.encode(&mut content).unwrap();
+        std::fs::write(&cache, content).unwrap();
+
+        compile();
+        assert!(read_all_content(&out_file).contains("pub struct CachedMessage {"));
+
+        // A change to an imported file invalidates the cache.
+        let mut types = read_all_content(protos.join("types.proto"));
+        types.push_str("\nmessage Added {}\n");
+        std::fs::write(protos.join("types.proto"), types).unwrap();
+
+        compile();
+        let content = read_all_content(&out_file);
+        assert!(content.contains("pub struct Message {"));
+        assert!(content.contains("pub struct Added {"));
+    }
+
     fn read_all_content(filepath: impl AsRef<Path>) -> String {
         let mut f = File::open(filepath).unwrap();
         let mut content = String::new();
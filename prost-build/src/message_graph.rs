@@ -90,6 +90,12 @@ impl MessageGraph {
         has_path_connecting(&self.graph, outer, inner, None)
     }
 
+    /// Returns the descriptor of the message with the given fully-qualified name.
+    pub fn get_message(&self, fq_message_name: &str) -> Option<&DescriptorProto> {
+        assert_eq!(".", &fq_message_name[..1]);
+        self.messages.get(fq_message_name)
+    }
+
     /// Returns `true` if this message can automatically derive Copy trait.
     pub fn can_message_derive_copy(&self, fq_message_name: &str) -> bool {
         assert_eq!(".", &fq_message_name[..1]);
@@ -182,7 +182,7 @@ impl Field {
         let key_mod = self.key_ty.module();
         let km = quote!(::prost::encoding::#key_mod::merge);
         let module = self.map_ty.module();
-        match &self.value_ty {
+        let merge = match &self.value_ty {
             ValueTy::Scalar(scalar::Ty::Enumeration(ty)) => {
                 let default = quote!(#ty::default() as i32);
                 quote! {
@@ -210,6 +210,18 @@ impl Field {
                     ctx,
                 )
             },
+        };
+        match self.map_ty {
+            MapTy::HashMap => {
+                let tag = self.tag;
+                quote! {
+                    {
+                        ::prost::encoding::hash_map::reserve(#tag, &mut #ident, buf, &ctx)?;
+                        #merge
+                    }
+                }
+            }
+            MapTy::BTreeMap => merge,
         }
     }
 
@@ -272,6 +284,8 @@ impl Field {
                 ident,
             );
             let insert_doc = format!("Inserts a key value pair into `{}`.", ident);
+            // String keys are converted into the key type of the map, which can be any type
+            // implementing `StringAdapter` and `From<String>`.
             Some(quote! {
                 #[doc=#get_doc]
                 pub fn #get(&self, key: #key_ref_ty) -> ::core::option::Option<#ty> {
@@ -282,7 +296,7 @@ impl Field {
                 }
                 #[doc=#insert_doc]
                 pub fn #insert(&mut self, key: #key_ty, value: #ty) -> ::core::option::Option<#ty> {
-                    self.#ident.insert(key, value as i32).and_then(|x| {
+                    self.#ident.insert(::core::convert::From::from(key), value as i32).and_then(|x| {
                         let result: ::core::result::Result<#ty, _> = ::core::convert::TryFrom::try_from(x);
                         result.ok()
                     })
@@ -302,10 +316,24 @@ impl Field {
             MapTy::HashMap => Ident::new("HashMap", Span::call_site()),
             MapTy::BTreeMap => Ident::new("BTreeMap", Span::call_site()),
         };
+        // The hasher type parameter of the map, which can be customized for hash maps.
+        let hasher = match self.map_ty {
+            MapTy::HashMap => quote!(, S),
+            MapTy::BTreeMap => quote!(),
+        };
 
         // A fake field for generating the debug wrapper
         let key_wrapper = fake_scalar(self.key_ty.clone()).debug(quote!(KeyWrapper));
-        let key = self.key_ty.rust_type();
+        // String keys and values can have any type implementing `StringAdapter`, so the wrapper
+        // is generic over them.
+        let (key, key_generics) = match self.key_ty {
+            scalar::Ty::String => (quote!(K), quote!(, K: ::core::fmt::Debug + 'a)),
+            _ => (self.key_ty.rust_type(), quote!()),
+        };
+        let key_args = match self.key_ty {
+            scalar::Ty::String => quote!(, K),
+            _ => quote!(),
+        };
         let value_wrapper = self.value_ty.debug();
         let libname = self.map_ty.lib();
         let fmt = quote! {
@@ -332,17 +360,22 @@ impl Field {
                     };
                 }
 
-                let value = ty.rust_type();
+                let (value, value_generics, value_args) = match ty {
+                    scalar::Ty::String => {
+                        (quote!(V), quote!(, V: ::core::fmt::Debug + 'a), quote!(, V))
+                    }
+                    _ => (ty.rust_type(), quote!(), quote!()),
+                };
                 quote! {
-                    struct #wrapper_name<'a>(&'a ::#libname::collections::#type_name<#key, #value>);
-                    impl<'a> ::core::fmt::Debug for #wrapper_name<'a> {
+                    struct #wrapper_name<'a #key_generics #value_generics #hasher>(&'a ::#libname::collections::#type_name<#key, #value #hasher>);
+                    impl<'a #key_generics #value_generics #hasher> ::core::fmt::Debug for #wrapper_name<'a #key_args #value_args #hasher> {
                         #fmt
                     }
                 }
             }
             ValueTy::Message => quote! {
-                struct #wrapper_name<'a, V: 'a>(&'a ::#libname::collections::#type_name<#key, V>);
-                impl<'a, V> ::core::fmt::Debug for #wrapper_name<'a, V>
+                struct #wrapper_name<'a #key_generics, V: 'a #hasher>(&'a ::#libname::collections::#type_name<#key, V #hasher>);
+                impl<'a #key_generics, V #hasher> ::core::fmt::Debug for #wrapper_name<'a #key_args, V #hasher>
                 where
                     V: ::core::fmt::Debug + 'a,
                 {
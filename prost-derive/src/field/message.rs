@@ -9,6 +9,7 @@ use crate::field::{set_bool, set_option, tag_attr, word_attr, Label};
 pub struct Field {
     pub label: Label,
     pub tag: u32,
+    pub lazy: bool,
 }
 
 impl Field {
@@ -17,6 +18,7 @@ impl Field {
         let mut label = None;
         let mut tag = None;
         let mut boxed = false;
+        let mut lazy = false;
 
         let mut unknown_attrs = Vec::new();
 
@@ -25,6 +27,8 @@ impl Field {
                 set_bool(&mut message, "duplicate message attribute")?;
             } else if word_attr("boxed", attr) {
                 set_bool(&mut boxed, "duplicate boxed attribute")?;
+            } else if word_attr("lazy", attr) {
+                set_bool(&mut lazy, "duplicate lazy attribute")?;
             } else if let Some(t) = tag_attr(attr)? {
                 set_option(&mut tag, t, "duplicate tag attributes")?;
             } else if let Some(l) = Label::from_attr(attr) {
@@ -53,6 +57,7 @@ impl Field {
         Ok(Some(Field {
             label: label.unwrap_or(Label::Optional),
             tag,
+            lazy,
         }))
     }
 
@@ -71,53 +76,94 @@ impl Field {
         }
     }
 
+    /// Returns the encoding module for the field.
+    fn module(&self) -> TokenStream {
+        if self.lazy {
+            quote!(::prost::encoding::lazy)
+        } else {
+            quote!(::prost::encoding::message)
+        }
+    }
+
     pub fn encode(&self, ident: TokenStream) -> TokenStream {
+        let module = self.module();
         let tag = self.tag;
         match self.label {
             Label::Optional => quote! {
                 if let Some(ref msg) = #ident {
-                    ::prost::encoding::message::encode(#tag, msg, buf);
+                    #module::encode(#tag, msg, buf);
                 }
             },
             Label::Required => quote! {
-                ::prost::encoding::message::encode(#tag, &#ident, buf);
+                #module::encode(#tag, &#ident, buf);
             },
             Label::Repeated => quote! {
                 for msg in &#ident {
-                    ::prost::encoding::message::encode(#tag, msg, buf);
+                    #module::encode(#tag, msg, buf);
                 }
             },
         }
     }
 
+    /// Returns a statement which encodes the field in front of the contents of a `ReverseBuf`.
+    /// Lazy fields are not supported.
+    pub fn encode_reverse(&self, ident: TokenStream) -> TokenStream {
+        let tag = self.tag;
+        match self.label {
+            Label::Optional => quote! {
+                if let Some(ref msg) = #ident {
+                    ::prost::encoding::message::encode_reverse(#tag, msg, buf);
+                }
+            },
+            Label::Required => quote! {
+                ::prost::encoding::message::encode_reverse(#tag, &#ident, buf);
+            },
+            Label::Repeated => quote! {
+                ::prost::encoding::message::encode_repeated_reverse(#tag, &#ident, buf);
+            },
+        }
+    }
+
     pub fn merge(&self, ident: TokenStream) -> TokenStream {
+        self.merge_with(self.module(), ident)
+    }
+
+    /// Returns an expression which evaluates to the result of merging a decoded
+    /// nested view into the field of a message view.
+    pub fn merge_view(&self, ident: TokenStream) -> TokenStream {
+        self.merge_with(quote!(::prost::encoding::message_view), ident)
+    }
+
+    fn merge_with(&self, module: TokenStream, ident: TokenStream) -> TokenStream {
+        let tag = self.tag;
         match self.label {
             Label::Optional => quote! {
-                ::prost::encoding::message::merge(wire_type,
-                                                 #ident.get_or_insert_with(::core::default::Default::default),
-                                                 buf,
-                                                 ctx)
+                #module::merge(wire_type,
+                               #ident.get_or_insert_with(::core::default::Default::default),
+                               buf,
+                               ctx)
             },
             Label::Required => quote! {
-                ::prost::encoding::message::merge(wire_type, #ident, buf, ctx)
+                #module::merge(wire_type, #ident, buf, ctx)
             },
             Label::Repeated => quote! {
-                ::prost::encoding::message::merge_repeated(wire_type, #ident, buf, ctx)
+                #module::merge_repeated(#tag, wire_type, #ident, buf, ctx)
             },
         }
     }
 
     pub fn encoded_len(&self, ident: TokenStream) -> TokenStream {
+        let module = self.module();
         let tag = self.tag;
         match self.label {
             Label::Optional => quote! {
-                #ident.as_ref().map_or(0, |msg| ::prost::encoding::message::encoded_len(#tag, msg))
+                #ident.as_ref().map_or(0, |msg| #module::encoded_len(#tag, msg))
             },
             Label::Required => quote! {
-                ::prost::encoding::message::encoded_len(#tag, &#ident)
+                #module::encoded_len(#tag, &#ident)
             },
             Label::Repeated => quote! {
-                ::prost::encoding::message::encoded_len_repeated(#tag, &#ident)
+                #module::encoded_len_repeated(#tag, &#ident)
             },
         }
     }
@@ -129,4 +175,31 @@ impl Field {
             Label::Repeated => quote!(#ident.clear()),
         }
     }
+
+    /// Returns an expression which decodes a value of the field into a message whose contents
+    /// are being replaced, reusing the current value, and a statement which finishes the field
+    /// once decoding is complete. `used` is a `usize` variable counting the decoded values.
+    pub fn replace(
+        &self,
+        ident: TokenStream,
+        used: TokenStream,
+    ) -> Option<(TokenStream, TokenStream)> {
+        if self.lazy {
+            return None;
+        }
+        Some(match self.label {
+            Label::Optional => (
+                quote!(::prost::encoding::message::replace_optional(wire_type, &mut #ident, &mut #used, buf, ctx.clone())),
+                quote!(if #used == 0 { #ident = ::core::option::Option::None; }),
+            ),
+            Label::Required => (
+                quote!(::prost::encoding::message::replace_singular(wire_type, &mut #ident, &mut #used, buf, ctx.clone())),
+                quote!(if #used == 0 { #ident.clear(); }),
+            ),
+            Label::Repeated => (
+                quote!(::prost::encoding::message::replace_repeated(wire_type, &mut #ident, &mut #used, buf, ctx.clone())),
+                quote!(#ident.truncate(#used);),
+            ),
+        })
+    }
 }
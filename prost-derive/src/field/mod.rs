@@ -33,7 +33,9 @@ impl Field {
     /// If the meta items are invalid, an error will be returned.
     /// If the field should be ignored, `None` is returned.
     pub fn new(attrs: Vec<Attribute>, inferred_tag: Option<u32>) -> Result<Option<Field>, Error> {
-        let attrs = prost_attrs(attrs)?;
+        let mut attrs = prost_attrs(attrs)?;
+        // The name of the field is read separately, by `name_attr`.
+        attrs.retain(|attr| !attr.path().is_ident("name"));
 
         // TODO: check for ignore attribute.
 
@@ -99,6 +101,26 @@ impl Field {
         }
     }
 
+    /// Returns a statement which encodes the field in front of the contents of a `ReverseBuf`.
+    ///
+    /// Message fields are written back to front, so that their length is known without sizing
+    /// them first. All other fields are sized, and then encoded front to back in the space
+    /// reserved for them.
+    pub fn encode_reverse(&self, ident: TokenStream) -> TokenStream {
+        match *self {
+            Field::Message(ref message) if !message.lazy => message.encode_reverse(ident),
+            _ => {
+                let encoded_len = self.encoded_len(ident.clone());
+                let encode = self.encode(ident);
+                quote! {
+                    buf.prepend_with(#encoded_len, |buf| {
+                        #encode
+                    });
+                }
+            }
+        }
+    }
+
     /// Returns an expression which evaluates to the result of merging a decoded
     /// value into the field.
     pub fn merge(&self, ident: TokenStream) -> TokenStream {
@@ -111,6 +133,18 @@ impl Field {
         }
     }
 
+    /// Returns an expression which evaluates to the result of merging a decoded
+    /// value into the field of a message view.
+    pub fn merge_view(&self, ident: TokenStream) -> Result<TokenStream, Error> {
+        match *self {
+            Field::Scalar(ref scalar) => Ok(scalar.merge_view(ident)),
+            Field::Message(ref message) => Ok(message.merge_view(ident)),
+            Field::Map(..) => bail!("map fields are not supported by message views"),
+            Field::Oneof(..) => bail!("oneof fields are not supported by message views"),
+            Field::Group(..) => bail!("group fields are not supported by message views"),
+        }
+    }
+
     /// Returns an expression which evaluates to the encoded length of the field.
     pub fn encoded_len(&self, ident: TokenStream) -> TokenStream {
         match *self {
@@ -122,6 +156,15 @@ impl Field {
         }
     }
 
+    /// Returns the encoded length of the field if it is the same for every value, which is the
+    /// case for required fixed-width fields.
+    pub fn constant_encoded_len(&self) -> Option<usize> {
+        match *self {
+            Field::Scalar(ref scalar) => scalar.constant_encoded_len(),
+            _ => None,
+        }
+    }
+
     /// Returns a statement which clears the field.
     pub fn clear(&self, ident: TokenStream) -> TokenStream {
         match *self {
@@ -133,6 +176,39 @@ impl Field {
         }
     }
 
+    /// Returns the code which decodes the field when the contents of a message are replaced,
+    /// reusing its current value, or `None` if the field is cleared instead. See
+    /// `message::Field::replace`.
+    pub fn replace(
+        &self,
+        ident: TokenStream,
+        used: TokenStream,
+    ) -> Option<(TokenStream, TokenStream)> {
+        match *self {
+            Field::Message(ref message) => message.replace(ident, used),
+            _ => None,
+        }
+    }
+
+    /// Returns the wire type the field is usually encoded with, and whether encoders usually
+    /// write the field several times in a row, or `None` for oneof fields, whose key depends on
+    /// the variant.
+    pub fn expected_key(&self) -> Option<(WireType, bool)> {
+        match *self {
+            Field::Scalar(ref scalar) => Some(match scalar.kind {
+                scalar::Kind::Packed => (WireType::LengthDelimited, false),
+                scalar::Kind::Repeated => (scalar.ty.wire_type(), true),
+                _ => (scalar.ty.wire_type(), false),
+            }),
+            Field::Message(ref message) => {
+                Some((WireType::LengthDelimited, message.label == Label::Repeated))
+            }
+            Field::Map(..) => Some((WireType::LengthDelimited, true)),
+            Field::Oneof(..) => None,
+            Field::Group(ref group) => Some((WireType::StartGroup, group.label == Label::Repeated)),
+        }
+    }
+
     pub fn default(&self) -> TokenStream {
         match *self {
             Field::Scalar(ref scalar) => scalar.default(),
@@ -174,6 +250,51 @@ impl Field {
     }
 }
 
+/// Returns the encoded length of the key of a field with the given tag.
+pub fn key_len(tag: u32) -> usize {
+    let mut key = tag << 3;
+    let mut len = 1;
+    while key >= 0x80 {
+        key >>= 7;
+        len += 1;
+    }
+    len
+}
+
+/// A Protobuf wire type.
+#[derive(Clone, Copy, PartialEq, Eq)]
+pub enum WireType {
+    Varint,
+    SixtyFourBit,
+    LengthDelimited,
+    StartGroup,
+    ThirtyTwoBit,
+}
+
+impl WireType {
+    /// Returns the value of the wire type in an encoded key.
+    pub fn value(self) -> u32 {
+        match self {
+            WireType::Varint => 0,
+            WireType::SixtyFourBit => 1,
+            WireType::LengthDelimited => 2,
+            WireType::StartGroup => 3,
+            WireType::ThirtyTwoBit => 5,
+        }
+    }
+
+    /// Returns the path of the wire type in the `prost` crate.
+    pub fn path(self) -> TokenStream {
+        match self {
+            WireType::Varint => quote!(::prost::encoding::WireType::Varint),
+            WireType::SixtyFourBit => quote!(::prost::encoding::WireType::SixtyFourBit),
+            WireType::LengthDelimited => quote!(::prost::encoding::WireType::LengthDelimited),
+            WireType::StartGroup => quote!(::prost::encoding::WireType::StartGroup),
+            WireType::ThirtyTwoBit => quote!(::prost::encoding::WireType::ThirtyTwoBit),
+        }
+    }
+}
+
 #[derive(Clone, Copy, PartialEq, Eq)]
 pub enum Label {
     /// An optional field.
@@ -224,6 +345,57 @@ impl fmt::Display for Label {
     }
 }
 
+/// Returns `true` if the attributes mark the field as the message's encoded length cache, i.e.
+/// `#[prost(cached_size)]`.
+pub fn is_cached_size(attrs: &[Attribute]) -> Result<bool, Error> {
+    is_special_field("cached_size", attrs)
+}
+
+/// Returns `true` if the attributes mark the field as the storage for the message's unknown
+/// fields, i.e. `#[prost(unknown_fields)]`.
+pub fn is_unknown_fields(attrs: &[Attribute]) -> Result<bool, Error> {
+    is_special_field("unknown_fields", attrs)
+}
+
+/// Returns `true` if the attributes consist of the single word `#[prost(<kind>)]`.
+fn is_special_field(kind: &str, attrs: &[Attribute]) -> Result<bool, Error> {
+    let attrs = prost_attrs(attrs.to_vec())?;
+    if !attrs.iter().any(|attr| word_attr(kind, attr)) {
+        return Ok(false);
+    }
+    if attrs.len() != 1 {
+        bail!(
+            "{} field may not have other attributes: #[prost({})]",
+            kind,
+            quote!(#(#attrs),*)
+        );
+    }
+    Ok(true)
+}
+
+/// Returns the name of the field in the `.proto` file, i.e. `#[prost(name = "fieldName")]`, if
+/// it is given because it differs from the name of the Rust field.
+pub fn name_attr(attrs: &[Attribute]) -> Result<Option<String>, Error> {
+    let mut name = None;
+    for attr in prost_attrs(attrs.to_vec())? {
+        if !attr.path().is_ident("name") {
+            continue;
+        }
+        match attr {
+            Meta::NameValue(MetaNameValue {
+                value:
+                    Expr::Lit(ExprLit {
+                        lit: Lit::Str(ref lit),
+                        ..
+                    }),
+                ..
+            }) => set_option(&mut name, lit.value(), "duplicate name attributes")?,
+            _ => bail!("invalid name attribute: {}", quote!(#attr)),
+        }
+    }
+    Ok(name)
+}
+
 /// Get the items belonging to the 'prost' list attribute, e.g. `#[prost(foo, bar="baz")]`.
 fn prost_attrs(attrs: Vec<Attribute>) -> Result<Vec<Meta>, Error> {
     let mut result = Vec::new();
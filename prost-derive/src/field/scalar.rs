@@ -5,7 +5,7 @@ use proc_macro2::{Span, TokenStream};
 use quote::{quote, ToTokens, TokenStreamExt};
 use syn::{parse_str, Expr, ExprLit, Ident, Index, Lit, LitByteStr, Meta, MetaNameValue, Path};
 
-use crate::field::{bool_attr, set_option, tag_attr, Label};
+use crate::field::{bool_attr, key_len, set_option, tag_attr, Label, WireType};
 
 /// A scalar protobuf field.
 #[derive(Clone)]
@@ -117,9 +117,9 @@ impl Field {
 
         match self.kind {
             Kind::Plain(ref default) => {
-                let default = default.typed();
+                let is_default = self.is_default(&ident, default);
                 quote! {
-                    if #ident != #default {
+                    if !(#is_default) {
                         #encode_fn(#tag, &#ident, buf);
                     }
                 }
@@ -138,7 +138,22 @@ impl Field {
     /// Returns an expression which evaluates to the result of merging a decoded
     /// scalar value into the field.
     pub fn merge(&self, ident: TokenStream) -> TokenStream {
-        let module = self.ty.module();
+        self.merge_with(self.ty.module(), ident)
+    }
+
+    /// Returns an expression which evaluates to the result of merging a decoded
+    /// scalar value into the field of a message view. `string` and `bytes`
+    /// values borrow from the input buffer.
+    pub fn merge_view(&self, ident: TokenStream) -> TokenStream {
+        let module = match self.ty {
+            Ty::String => Ident::new("string_view", Span::call_site()),
+            Ty::Bytes(..) => Ident::new("bytes_view", Span::call_site()),
+            _ => self.ty.module(),
+        };
+        self.merge_with(module, ident)
+    }
+
+    fn merge_with(&self, module: Ident, ident: TokenStream) -> TokenStream {
         let merge_fn = match self.kind {
             Kind::Plain(..) | Kind::Optional(..) | Kind::Required(..) => quote!(merge),
             Kind::Repeated | Kind::Packed => quote!(merge_repeated),
@@ -160,6 +175,10 @@ impl Field {
 
     /// Returns an expression which evaluates to the encoded length of the field.
     pub fn encoded_len(&self, ident: TokenStream) -> TokenStream {
+        if let Some(width) = self.ty.fixed_width() {
+            return self.fixed_encoded_len(ident, width);
+        }
+
         let module = self.ty.module();
         let encoded_len_fn = match self.kind {
             Kind::Plain(..) | Kind::Optional(..) | Kind::Required(..) => quote!(encoded_len),
@@ -171,9 +190,9 @@ impl Field {
 
         match self.kind {
             Kind::Plain(ref default) => {
-                let default = default.typed();
+                let is_default = self.is_default(&ident, default);
                 quote! {
-                    if #ident != #default {
+                    if !(#is_default) {
                         #encoded_len_fn(#tag, &#ident)
                     } else {
                         0
@@ -189,12 +208,57 @@ impl Field {
         }
     }
 
+    /// Returns an expression which evaluates to the encoded length of a field whose values are
+    /// all encoded with `width` bytes. The lengths of its keys and values are computed at compile
+    /// time.
+    fn fixed_encoded_len(&self, ident: TokenStream, width: usize) -> TokenStream {
+        let key_len = key_len(self.tag);
+        let len = key_len + width;
+        match self.kind {
+            Kind::Plain(ref default) => {
+                let is_default = self.is_default(&ident, default);
+                quote!(if !(#is_default) { #len } else { 0 })
+            }
+            Kind::Optional(..) => quote!(if #ident.is_some() { #len } else { 0 }),
+            Kind::Required(..) => quote!(#len),
+            Kind::Repeated => quote!(#len * #ident.len()),
+            Kind::Packed => quote! {
+                if #ident.is_empty() {
+                    0
+                } else {
+                    let len = #width * #ident.len();
+                    #key_len + ::prost::encoding::encoded_len_varint(len as u64) + len
+                }
+            },
+        }
+    }
+
+    /// Returns the encoded length of the field if it is the same for every value.
+    pub fn constant_encoded_len(&self) -> Option<usize> {
+        match (&self.kind, self.ty.fixed_width()) {
+            (Kind::Required(..), Some(width)) => Some(key_len(self.tag) + width),
+            _ => None,
+        }
+    }
+
+    /// Returns an expression which evaluates to `true` if the field `ident` has its default
+    /// value.
+    fn is_default(&self, ident: &TokenStream, default: &DefaultValue) -> TokenStream {
+        let default = default.typed();
+        match self.ty {
+            // String fields can have any type implementing `StringAdapter`.
+            Ty::String => quote!(::prost::encoding::StringAdapter::as_str(&#ident) == #default),
+            _ => quote!(#ident == #default),
+        }
+    }
+
     pub fn clear(&self, ident: TokenStream) -> TokenStream {
         match self.kind {
             Kind::Plain(ref default) | Kind::Required(ref default) => {
                 let default = default.typed();
                 match self.ty {
-                    Ty::String | Ty::Bytes(..) => quote!(#ident.clear()),
+                    Ty::String => quote!(::prost::encoding::StringAdapter::clear(&mut #ident)),
+                    Ty::Bytes(..) => quote!(#ident.clear()),
                     _ => quote!(#ident = #default),
                 }
             }
@@ -238,12 +302,21 @@ impl Field {
     /// Returns a fragment for formatting the field `ident` in `Debug`.
     pub fn debug(&self, wrapper_name: TokenStream) -> TokenStream {
         let wrapper = self.debug_inner(quote!(Inner));
-        let inner_ty = self.ty.rust_type();
+        // String fields can have any type implementing `StringAdapter`, so their wrappers are
+        // generic over it.
+        let (generics, inner_ty) = match self.ty {
+            Ty::String => (quote!(, T: ::core::fmt::Debug), quote!(T)),
+            _ => (quote!(), self.ty.rust_type()),
+        };
+        let args = match self.ty {
+            Ty::String => quote!(, T),
+            _ => quote!(),
+        };
         match self.kind {
             Kind::Plain(_) | Kind::Required(_) => self.debug_inner(wrapper_name),
             Kind::Optional(_) => quote! {
-                struct #wrapper_name<'a>(&'a ::core::option::Option<#inner_ty>);
-                impl<'a> ::core::fmt::Debug for #wrapper_name<'a> {
+                struct #wrapper_name<'a #generics>(&'a ::core::option::Option<#inner_ty>);
+                impl<'a #generics> ::core::fmt::Debug for #wrapper_name<'a #args> {
                     fn fmt(&self, f: &mut ::core::fmt::Formatter) -> ::core::fmt::Result {
                         #wrapper
                         ::core::fmt::Debug::fmt(&self.0.as_ref().map(Inner), f)
@@ -252,8 +325,8 @@ impl Field {
             },
             Kind::Repeated | Kind::Packed => {
                 quote! {
-                    struct #wrapper_name<'a>(&'a ::prost::alloc::vec::Vec<#inner_ty>);
-                    impl<'a> ::core::fmt::Debug for #wrapper_name<'a> {
+                    struct #wrapper_name<'a #generics>(&'a ::prost::alloc::vec::Vec<#inner_ty>);
+                    impl<'a #generics> ::core::fmt::Debug for #wrapper_name<'a #args> {
                         fn fmt(&self, f: &mut ::core::fmt::Formatter) -> ::core::fmt::Result {
                             let mut vec_builder = f.debug_list();
                             for v in self.0 {
@@ -566,6 +639,28 @@ impl Ty {
         }
     }
 
+    /// Returns the wire type of a single value of the scalar type.
+    pub fn wire_type(&self) -> WireType {
+        match *self {
+            Ty::Float | Ty::Fixed32 | Ty::Sfixed32 => WireType::ThirtyTwoBit,
+            Ty::Double | Ty::Fixed64 | Ty::Sfixed64 => WireType::SixtyFourBit,
+            Ty::String | Ty::Bytes(..) => WireType::LengthDelimited,
+            _ => WireType::Varint,
+        }
+    }
+
+    /// Returns the number of bytes every value of the scalar type is encoded with, or `None` if
+    /// it depends on the value.
+    pub fn fixed_width(&self) -> Option<usize> {
+        match *self {
+            Ty::Float | Ty::Fixed32 | Ty::Sfixed32 => Some(4),
+            Ty::Double | Ty::Fixed64 | Ty::Sfixed64 => Some(8),
+            // `true` and `false` are encoded as the single-byte varints 1 and 0.
+            Ty::Bool => Some(1),
+            _ => None,
+        }
+    }
+
     /// Returns false if the scalar type is length delimited (i.e., `string` or `bytes`).
     pub fn is_numeric(&self) -> bool {
         !matches!(self, Ty::String | Ty::Bytes(..))
@@ -782,7 +877,7 @@ impl DefaultValue {
     pub fn owned(&self) -> TokenStream {
         match *self {
             DefaultValue::String(ref value) if value.is_empty() => {
-                quote!(::prost::alloc::string::String::new())
+                quote!(::core::default::Default::default())
             }
             DefaultValue::String(ref value) => quote!(#value.into()),
             DefaultValue::Bytes(ref value) if value.is_empty() => {
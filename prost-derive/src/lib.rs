@@ -5,7 +5,7 @@
 extern crate alloc;
 extern crate proc_macro;
 
-use anyhow::{bail, Error};
+use anyhow::{anyhow, bail, Error};
 use itertools::Itertools;
 use proc_macro2::{Span, TokenStream};
 use quote::quote;
@@ -15,7 +15,10 @@ use syn::{
 };
 
 mod field;
-use crate::field::Field;
+use crate::field::{is_cached_size, is_unknown_fields, name_attr, Field};
+
+/// Returns whether a field carries a special, non-protobuf attribute.
+type SpecialFieldFn = fn(&[syn::Attribute]) -> Result<bool, Error>;
 
 fn try_message(input: TokenStream) -> Result<TokenStream, Error> {
     let input: DeriveInput = syn::parse2(input)?;
@@ -23,10 +26,15 @@ fn try_message(input: TokenStream) -> Result<TokenStream, Error> {
     let ident = input.ident;
 
     syn::custom_keyword!(skip_debug);
+    syn::custom_keyword!(dyn_buf);
     let skip_debug = input
         .attrs
-        .into_iter()
+        .iter()
         .any(|a| a.path().is_ident("prost") && a.parse_args::<skip_debug>().is_ok());
+    let dyn_buf = input
+        .attrs
+        .iter()
+        .any(|a| a.path().is_ident("prost") && a.parse_args::<dyn_buf>().is_ok());
 
     let variant_data = match input.data {
         Data::Struct(variant_data) => variant_data,
@@ -56,6 +64,10 @@ fn try_message(input: TokenStream) -> Result<TokenStream, Error> {
     };
 
     let mut next_tag: u32 = 1;
+    let mut cached_size = None;
+    let mut unknown_fields = None;
+    let mut field_types = Vec::new();
+    let mut field_names = Vec::new();
     let mut fields = fields
         .into_iter()
         .enumerate()
@@ -67,10 +79,60 @@ fn try_message(input: TokenStream) -> Result<TokenStream, Error> {
                 };
                 quote!(#index)
             });
+            let special_fields: [(&str, SpecialFieldFn, &mut Option<TokenStream>); 2] = [
+                ("cached_size", is_cached_size, &mut cached_size),
+                ("unknown_fields", is_unknown_fields, &mut unknown_fields),
+            ];
+            for (kind, is_special, special) in special_fields {
+                match is_special(&field.attrs) {
+                    Ok(true) if !is_struct => {
+                        return Some(Err(anyhow!(
+                            "{} field {}.{} is only supported on structs with named fields",
+                            kind,
+                            ident,
+                            field_ident
+                        )));
+                    }
+                    Ok(true) if special.is_some() => {
+                        return Some(Err(anyhow!(
+                            "message {} has multiple {} fields",
+                            ident,
+                            kind
+                        )));
+                    }
+                    Ok(true) => {
+                        *special = Some(field_ident);
+                        return None;
+                    }
+                    Ok(false) => (),
+                    Err(err) => {
+                        return Some(Err(err.context(format!(
+                            "invalid message field {}.{}",
+                            ident, field_ident
+                        ))));
+                    }
+                }
+            }
+            let name = match name_attr(&field.attrs) {
+                Ok(name) => name,
+                Err(err) => {
+                    return Some(Err(err.context(format!(
+                        "invalid message field {}.{}",
+                        ident, field_ident
+                    ))));
+                }
+            };
             match Field::new(field.attrs, Some(next_tag)) {
-                Ok(Some(field)) => {
-                    next_tag = field.tags().iter().max().map(|t| t + 1).unwrap_or(next_tag);
-                    Some(Ok((field_ident, field)))
+                Ok(Some(parsed)) => {
+                    next_tag = parsed
+                        .tags()
+                        .iter()
+                        .max()
+                        .map(|t| t + 1)
+                        .unwrap_or(next_tag);
+                    field_types.push(field.ty);
+                    field_names.push(name);
+                    Some(Ok((field_ident, parsed)))
                 }
                 Ok(None) => None,
                 Err(err) => Some(Err(
@@ -103,9 +165,16 @@ fn try_message(input: TokenStream) -> Result<TokenStream, Error> {
         )
     };
 
+    // The fields which are always encoded with the same length are sized at compile time.
+    let constant_encoded_len = fields
+        .iter()
+        .filter_map(|(_, field)| field.constant_encoded_len())
+        .sum::<usize>();
     let encoded_len = fields
         .iter()
-        .map(|(field_ident, field)| field.encoded_len(quote!(self.#field_ident)));
+        .filter(|(_, field)| field.constant_encoded_len().is_none())
+        .map(|(field_ident, field)| field.encoded_len(quote!(self.#field_ident)))
+        .collect::<Vec<_>>();
 
     let encode = fields
         .iter()
@@ -135,17 +204,79 @@ fn try_message(input: TokenStream) -> Result<TokenStream, Error> {
         )
     };
 
+    let resolve_field_path = if is_struct {
+        resolve_field_path(&unsorted_fields, &field_types, &field_names)
+    } else {
+        quote!()
+    };
+    // Messages with non-generic methods decode their fields with `merge_field_dyn`.
+    let merge_field = if dyn_buf {
+        quote!(merge_field_dyn)
+    } else {
+        quote!(merge_field)
+    };
+    let merge_fields = merge_fields(&fields, &merge_field);
+    let replace_fields = replace_fields(&ident, &fields, unknown_fields.as_ref(), &merge_field);
+
+    // Unknown fields are skipped, or captured if the message preserves them.
+    let merge_unknown = match unknown_fields {
+        Some(ref unknown_fields) => {
+            quote!(self.#unknown_fields.merge_field(tag, wire_type, buf, ctx))
+        }
+        None => quote!(::prost::instrument::skip_field::<Self>(
+            wire_type, tag, buf, ctx
+        )),
+    };
+    // Preserved unknown fields are encoded after the known fields.
+    let encode_unknown = unknown_fields
+        .iter()
+        .map(|field_ident| quote!(self.#field_ident.encode_raw(buf);));
+    // When encoding in reverse, the unknown fields are written first.
+    let encode_reverse = unknown_fields
+        .iter()
+        .map(|field_ident| {
+            quote! {
+                buf.prepend_with(self.#field_ident.encoded_len(), |buf| {
+                    self.#field_ident.encode_raw(buf)
+                });
+            }
+        })
+        .chain(
+            fields
+                .iter()
+                .rev()
+                .map(|(field_ident, field)| field.encode_reverse(quote!(self.#field_ident))),
+        );
+    let encoded_len = encoded_len
+        .into_iter()
+        .chain(
+            unknown_fields
+                .iter()
+                .map(|field_ident| quote!(self.#field_ident.encoded_len())),
+        )
+        .collect::<Vec<_>>();
+
     let clear = fields
         .iter()
-        .map(|(field_ident, field)| field.clear(quote!(self.#field_ident)));
+        .map(|(field_ident, field)| field.clear(quote!(self.#field_ident)))
+        .chain(
+            unknown_fields
+                .iter()
+                .map(|field_ident| quote!(self.#field_ident.clear())),
+        );
 
     let default = if is_struct {
         let default = fields.iter().map(|(field_ident, field)| {
             let value = field.default();
             quote!(#field_ident: #value,)
         });
+        let special_default = cached_size
+            .iter()
+            .chain(unknown_fields.iter())
+            .map(|field_ident| quote!(#field_ident: ::core::default::Default::default(),));
         quote! {#ident {
             #(#default)*
+            #(#special_default)*
         }}
     } else {
         let default = fields.iter().map(|(_, field)| {
@@ -172,11 +303,84 @@ fn try_message(input: TokenStream) -> Result<TokenStream, Error> {
         }
     };
 
-    let expanded = quote! {
-        impl #impl_generics ::prost::Message for #ident #ty_generics #where_clause {
+    let encoded_len_methods = match cached_size {
+        Some(ref cached_size) => quote! {
+            #[inline]
+            fn encoded_len(&self) -> usize {
+                let len = #constant_encoded_len #(+ #encoded_len)*;
+                self.#cached_size.set(len);
+                len
+            }
+
+            #[inline]
+            fn cached_encoded_len(&self) -> usize {
+                self.#cached_size.get()
+            }
+        },
+        None => quote! {
+            #[inline]
+            fn encoded_len(&self) -> usize {
+                #constant_encoded_len #(+ #encoded_len)*
+            }
+        },
+    };
+
+    let encode_raw = quote! {
+        let instrument = ::prost::instrument::Encode::start(buf);
+        #(#encode)*
+        #(#encode_unknown)*
+        instrument.finish::<Self>(buf);
+    };
+    let merge_field_body = quote! {
+        #struct_name
+        // Fields which are not selected by the projection being decoded are skipped.
+        let ctx = match ctx.select_field(tag) {
+            ::core::option::Option::Some(ctx) => ctx,
+            ::core::option::Option::None => {
+                return ::prost::instrument::skip_field::<Self>(wire_type, tag, buf, ctx)
+            }
+        };
+        match tag {
+            #(#merge)*
+            _ => {
+                ::prost::instrument::unknown_field::<Self>(tag, wire_type);
+                #merge_unknown
+            }
+        }
+    };
+    let buf_methods = if dyn_buf {
+        dyn_buf_methods(encode_raw, merge_field_body, merge_fields, replace_fields)
+    } else {
+        let merge_fields = merge_fields.map(|merge_fields| {
+            quote! {
+                fn merge_fields(
+                    &mut self,
+                    buf: &mut impl ::prost::bytes::Buf,
+                    limit: usize,
+                    ctx: ::prost::encoding::DecodeContext,
+                ) -> ::core::result::Result<(), ::prost::DecodeError> {
+                    #merge_fields
+                }
+            }
+        });
+        let replace_fields = replace_fields.map(|replace_fields| {
+            quote! {
+                fn replace_fields(
+                    &mut self,
+                    buf: &mut impl ::prost::bytes::Buf,
+                    limit: usize,
+                    ctx: ::prost::encoding::DecodeContext,
+                ) -> ::core::result::Result<(), ::prost::DecodeError> {
+                    #replace_fields
+                }
+            }
+        });
+        let merge_fields = merge_fields.unwrap_or_default();
+        let replace_fields = replace_fields.unwrap_or_default();
+        quote! {
             #[allow(unused_variables)]
             fn encode_raw(&self, buf: &mut impl ::prost::bytes::BufMut) {
-                #(#encode)*
+                #encode_raw
             }
 
             #[allow(unused_variables)]
@@ -188,18 +392,30 @@ fn try_message(input: TokenStream) -> Result<TokenStream, Error> {
                 ctx: ::prost::encoding::DecodeContext,
             ) -> ::core::result::Result<(), ::prost::DecodeError>
             {
-                #struct_name
-                match tag {
-                    #(#merge)*
-                    _ => ::prost::encoding::skip_field(wire_type, tag, buf, ctx),
-                }
+                #merge_field_body
             }
 
-            #[inline]
-            fn encoded_len(&self) -> usize {
-                0 #(+ #encoded_len)*
+            #merge_fields
+
+            #replace_fields
+        }
+    };
+
+    let expanded = quote! {
+        impl #impl_generics ::prost::Message for #ident #ty_generics #where_clause {
+            #buf_methods
+
+            #[allow(unused_variables)]
+            fn encode_raw_reverse(&self, buf: &mut ::prost::ReverseBuf) {
+                let instrument = ::prost::instrument::Encode::start_reverse(buf);
+                #(#encode_reverse)*
+                instrument.finish_reverse::<Self>(buf);
             }
 
+            #resolve_field_path
+
+            #encoded_len_methods
+
             fn clear(&mut self) {
                 #(#clear;)*
             }
@@ -255,11 +471,470 @@ fn try_message(input: TokenStream) -> Result<TokenStream, Error> {
     Ok(expanded)
 }
 
+/// Returns the body of `Message::merge_fields`, which predicts the key of the next field, or
+/// `None` if no key can be predicted.
+///
+/// Encoders write fields in tag order, and write repeated fields in a row, so after decoding a
+/// field the encoded key of the next field is usually known. The predicted key is compared with
+/// the next bytes of the buffer, which is cheaper than decoding the key. On a mismatch the key
+/// is decoded as usual.
+fn merge_fields(fields: &[(TokenStream, Field)], merge_field: &TokenStream) -> Option<TokenStream> {
+    // The fields with a predictable key, in tag order.
+    let expected = fields
+        .iter()
+        .filter_map(|(_, field)| {
+            let (wire_type, repeated) = field.expected_key()?;
+            let tag = field.tags()[0];
+            // Only keys of at most two bytes are predicted.
+            if tag >= 1 << 11 {
+                return None;
+            }
+            Some((tag, wire_type, repeated))
+        })
+        .collect::<Vec<_>>();
+    if expected.is_empty() {
+        return None;
+    }
+
+    // The index of the key expected after each field. `expected.len()` predicts no key.
+    let after = |tag: u32| {
+        expected
+            .iter()
+            .position(|&(expected_tag, _, repeated)| {
+                expected_tag > tag || (repeated && expected_tag == tag)
+            })
+            .unwrap_or(expected.len())
+    };
+
+    let keys = expected.iter().map(|&(tag, wire_type, _)| {
+        let key = (tag << 3) | wire_type.value();
+        let (key, mask, len) = if key < 0x80 {
+            (key as u16, 0x00ffu16, 1usize)
+        } else {
+            (
+                ((key & 0x7f) | 0x80 | ((key >> 7) << 8)) as u16,
+                0xffffu16,
+                2usize,
+            )
+        };
+        let wire_type = wire_type.path();
+        quote!((#key, #mask, #len, #tag, #wire_type),)
+    });
+
+    let next = fields.iter().map(|(_, field)| {
+        let tags = field.tags();
+        let next = tags.iter().map(|&tag| after(tag));
+        quote!(#(#tags => #next,)*)
+    });
+
+    Some(quote! {
+        // For each field with a predictable key, in tag order: the first two bytes of the
+        // encoded key as a little-endian integer, the mask of the bytes which belong to the
+        // key, the length of the key, the tag and the wire type.
+        const EXPECTED: &[(u16, u16, usize, u32, ::prost::encoding::WireType)] =
+            &[#(#keys)*];
+
+        let instrument = ::prost::instrument::Decode::start(buf, &ctx);
+        let mut next = 0;
+        while buf.remaining() > limit {
+            // Every encoded field is at least two bytes long, so a chunk which starts with a
+            // predictable key always holds two bytes.
+            let prefix = match buf.chunk() {
+                [first, second, ..] => u16::from_le_bytes([*first, *second]),
+                _ => 0,
+            };
+            let (tag, wire_type) = match EXPECTED.get(next) {
+                Some(&(key, mask, len, tag, wire_type)) if prefix & mask == key => {
+                    buf.advance(len);
+                    (tag, wire_type)
+                }
+                _ => ::prost::encoding::decode_key(buf)?,
+            };
+            self.#merge_field(tag, wire_type, buf, ctx.clone())?;
+            next = match tag {
+                #(#next)*
+                _ => next,
+            };
+        }
+        instrument.finish::<Self>(buf);
+        ::core::result::Result::Ok(())
+    })
+}
+
+/// Returns the implementation of `Message::resolve_field_path`, which maps field names to tags,
+/// or nothing if the message has no named fields.
+///
+/// `types` holds the type of each field, and `names` the name given by its `name` attribute, in
+/// declaration order. Fields are named by their `.proto` name, which is the name of the Rust
+/// field unless the attribute gives it. The rest of a path is resolved in the type of a message or
+/// group field; paths can not continue into other fields.
+fn resolve_field_path(
+    fields: &[(TokenStream, Field)],
+    types: &[syn::Type],
+    names: &[Option<String>],
+) -> TokenStream {
+    let arms = fields
+        .iter()
+        .zip(types)
+        .zip(names)
+        .filter_map(|(((field_ident, field), ty), name)| {
+            let nested = match field {
+                Field::Message(message) if !message.lazy => true,
+                Field::Group(_) => true,
+                Field::Scalar(_) | Field::Message(_) | Field::Map(_) => false,
+                Field::Oneof(_) => return None,
+            };
+            let name = match name {
+                Some(name) => name.clone(),
+                None => field_ident.to_string().trim_start_matches("r#").to_owned(),
+            };
+            let tag = field.tags()[0];
+            Some(if nested {
+                let ty = message_type(ty);
+                quote! {
+                    (#name, rest) => {
+                        tags.push(#tag);
+                        match rest {
+                            ::core::option::Option::Some(rest) => {
+                                <#ty as ::prost::Message>::resolve_field_path(rest, tags)
+                            }
+                            ::core::option::Option::None => true,
+                        }
+                    }
+                }
+            } else {
+                quote! {
+                    (#name, ::core::option::Option::None) => {
+                        tags.push(#tag);
+                        true
+                    }
+                }
+            })
+        })
+        .collect::<Vec<_>>();
+    if arms.is_empty() {
+        return quote!();
+    }
+
+    quote! {
+        fn resolve_field_path(path: &str, tags: &mut ::prost::alloc::vec::Vec<u32>) -> bool {
+            let (name, rest) = match path.split_once('.') {
+                ::core::option::Option::Some((name, rest)) => (name, ::core::option::Option::Some(rest)),
+                ::core::option::Option::None => (path, ::core::option::Option::None),
+            };
+            match (name, rest) {
+                #(#arms)*
+                _ => false,
+            }
+        }
+    }
+}
+
+/// Returns the message type of a message field: its type without `Option`, `Box` and `Vec`
+/// wrappers.
+fn message_type(ty: &syn::Type) -> &syn::Type {
+    if let syn::Type::Path(syn::TypePath { qself: None, path }) = ty {
+        if let Some(segment) = path.segments.last() {
+            if let syn::PathArguments::AngleBracketed(ref arguments) = segment.arguments {
+                if let Some(syn::GenericArgument::Type(inner)) = arguments.args.first() {
+                    if ["Option", "Box", "Vec"]
+                        .iter()
+                        .any(|name| segment.ident == name)
+                    {
+                        return message_type(inner);
+                    }
+                }
+            }
+        }
+    }
+    ty
+}
+
+/// Returns the body of `Message::replace_fields`, which reuses the current values of the message
+/// fields, or `None` if the message has no reusable fields.
+fn replace_fields(
+    ident: &Ident,
+    fields: &[(TokenStream, Field)],
+    unknown_fields: Option<&TokenStream>,
+    merge_field: &TokenStream,
+) -> Option<TokenStream> {
+    let mut clear = unknown_fields
+        .iter()
+        .map(|field_ident| quote!(self.#field_ident.clear()))
+        .collect::<Vec<_>>();
+    let mut replace = Vec::new();
+    let mut finish = Vec::new();
+    for (field_ident, field) in fields {
+        let index = replace.len();
+        let used = quote!(used[#index]);
+        match field.replace(quote!(self.#field_ident), used) {
+            Some((merge, finish_field)) => {
+                let tag = field.tags()[0];
+                replace.push(quote! {
+                    #tag => #merge.map_err(|mut error| {
+                        error.push(STRUCT_NAME, stringify!(#field_ident));
+                        error
+                    })?,
+                });
+                finish.push(finish_field);
+            }
+            None => clear.push(field.clear(quote!(self.#field_ident))),
+        }
+    }
+    if replace.is_empty() {
+        return None;
+    }
+    let count = replace.len();
+
+    Some(quote! {
+        const STRUCT_NAME: &'static str = stringify!(#ident);
+        #(#clear;)*
+        let instrument = ::prost::instrument::Decode::start(buf, &ctx);
+        // The number of values decoded for each reused field.
+        let mut used = [0usize; #count];
+        while buf.remaining() > limit {
+            let (tag, wire_type) = ::prost::encoding::decode_key(buf)?;
+            match tag {
+                #(#replace)*
+                _ => self.#merge_field(tag, wire_type, buf, ctx.clone())?,
+            }
+        }
+        #(#finish)*
+        instrument.finish::<Self>(buf);
+        ::core::result::Result::Ok(())
+    })
+}
+
+/// Returns the methods of `Message` which take a buffer, for a message derived with
+/// `#[prost(dyn_buf)]`.
+///
+/// The bodies are compiled once, for `dyn Buf` and `dyn DynBufMut`, in the non-generic `_dyn`
+/// methods. The generic methods only convert the buffer to a trait object, so they add little
+/// code for every buffer type the message is used with.
+fn dyn_buf_methods(
+    encode_raw: TokenStream,
+    merge_field: TokenStream,
+    merge_fields: Option<TokenStream>,
+    replace_fields: Option<TokenStream>,
+) -> TokenStream {
+    let merge_fields = merge_fields.unwrap_or_else(|| {
+        quote! {
+            let instrument = ::prost::instrument::Decode::start(buf, &ctx);
+            while buf.remaining() > limit {
+                let (tag, wire_type) = ::prost::encoding::decode_key(buf)?;
+                self.merge_field_dyn(tag, wire_type, buf, ctx.clone())?;
+            }
+            instrument.finish::<Self>(buf);
+            ::core::result::Result::Ok(())
+        }
+    });
+    let replace_fields = replace_fields.unwrap_or_else(|| {
+        quote! {
+            ::prost::Message::clear(self);
+            self.merge_fields_dyn(buf, limit, ctx)
+        }
+    });
+
+    quote! {
+        #[inline]
+        fn encode_raw(&self, buf: &mut impl ::prost::bytes::BufMut) {
+            self.encode_raw_dyn(buf)
+        }
+
+        #[allow(unused_variables)]
+        fn encode_raw_dyn(&self, buf: &mut dyn ::prost::encoding::DynBufMut) {
+            #encode_raw
+        }
+
+        #[inline]
+        fn merge_field(
+            &mut self,
+            tag: u32,
+            wire_type: ::prost::encoding::WireType,
+            buf: &mut impl ::prost::bytes::Buf,
+            ctx: ::prost::encoding::DecodeContext,
+        ) -> ::core::result::Result<(), ::prost::DecodeError> {
+            self.merge_field_dyn(tag, wire_type, buf, ctx)
+        }
+
+        #[allow(unused_variables)]
+        fn merge_field_dyn(
+            &mut self,
+            tag: u32,
+            wire_type: ::prost::encoding::WireType,
+            buf: &mut dyn ::prost::bytes::Buf,
+            ctx: ::prost::encoding::DecodeContext,
+        ) -> ::core::result::Result<(), ::prost::DecodeError> {
+            #merge_field
+        }
+
+        #[inline]
+        fn merge_fields(
+            &mut self,
+            buf: &mut impl ::prost::bytes::Buf,
+            limit: usize,
+            ctx: ::prost::encoding::DecodeContext,
+        ) -> ::core::result::Result<(), ::prost::DecodeError> {
+            self.merge_fields_dyn(buf, limit, ctx)
+        }
+
+        fn merge_fields_dyn(
+            &mut self,
+            buf: &mut dyn ::prost::bytes::Buf,
+            limit: usize,
+            ctx: ::prost::encoding::DecodeContext,
+        ) -> ::core::result::Result<(), ::prost::DecodeError> {
+            #merge_fields
+        }
+
+        #[inline]
+        fn replace_fields(
+            &mut self,
+            buf: &mut impl ::prost::bytes::Buf,
+            limit: usize,
+            ctx: ::prost::encoding::DecodeContext,
+        ) -> ::core::result::Result<(), ::prost::DecodeError> {
+            self.replace_fields_dyn(buf, limit, ctx)
+        }
+
+        fn replace_fields_dyn(
+            &mut self,
+            buf: &mut dyn ::prost::bytes::Buf,
+            limit: usize,
+            ctx: ::prost::encoding::DecodeContext,
+        ) -> ::core::result::Result<(), ::prost::DecodeError> {
+            #replace_fields
+        }
+    }
+}
+
 #[proc_macro_derive(Message, attributes(prost))]
 pub fn message(input: proc_macro::TokenStream) -> proc_macro::TokenStream {
     try_message(input.into()).unwrap().into()
 }
 
+fn try_message_view(input: TokenStream) -> Result<TokenStream, Error> {
+    let input: DeriveInput = syn::parse2(input)?;
+
+    let ident = input.ident;
+
+    let fields = match input.data {
+        Data::Struct(DataStruct {
+            fields: Fields::Named(FieldsNamed { named: fields, .. }),
+            ..
+        }) => fields,
+        Data::Struct(..) => bail!("MessageView can only be derived for a struct with named fields"),
+        Data::Enum(..) => bail!("MessageView can not be derived for an enum"),
+        Data::Union(..) => bail!("MessageView can not be derived for a union"),
+    };
+
+    let generics = &input.generics;
+    let lifetime = match generics.lifetimes().next() {
+        Some(lifetime_def) => &lifetime_def.lifetime,
+        None => bail!("MessageView {} must have a lifetime parameter", ident),
+    };
+    let (impl_generics, ty_generics, where_clause) = generics.split_for_impl();
+
+    // Fields without a `#[prost(..)]` attribute, such as lifetime markers, are left at their
+    // default value.
+    let mut next_tag: u32 = 1;
+    let mut fields = fields
+        .into_iter()
+        .filter(|field| field.attrs.iter().any(|attr| attr.path().is_ident("prost")))
+        .map(|field| {
+            let field_ident = field.ident.unwrap();
+            let field = Field::new(field.attrs, Some(next_tag))
+                .and_then(|field| {
+                    let field = field.unwrap();
+                    let merge = field.merge_view(quote!(value))?;
+                    Ok((field, merge))
+                })
+                .map_err(|err| {
+                    err.context(format!(
+                        "invalid message view field {}.{}",
+                        ident, field_ident
+                    ))
+                })?;
+            next_tag = field
+                .0
+                .tags()
+                .iter()
+                .max()
+                .map(|t| t + 1)
+                .unwrap_or(next_tag);
+            Ok((field_ident, field))
+        })
+        .collect::<Result<Vec<_>, Error>>()?;
+
+    fields.sort_by_key(|(_, (field, _))| field.tags().into_iter().min().unwrap());
+
+    if let Some(duplicate_tag) = fields
+        .iter()
+        .flat_map(|(_, (field, _))| field.tags())
+        .duplicates()
+        .next()
+    {
+        bail!(
+            "message view {} has multiple fields with tag {}",
+            ident,
+            duplicate_tag
+        )
+    };
+
+    let merge = fields.iter().map(|(field_ident, (field, merge))| {
+        let tags = field.tags().into_iter().map(|tag| quote!(#tag));
+        let tags = Itertools::intersperse(tags, quote!(|));
+
+        quote! {
+            #(#tags)* => {
+                let mut value = &mut self.#field_ident;
+                #merge.map_err(|mut error| {
+                    error.push(STRUCT_NAME, stringify!(#field_ident));
+                    error
+                })
+            },
+        }
+    });
+
+    let struct_name = if fields.is_empty() {
+        quote!()
+    } else {
+        quote!(
+            const STRUCT_NAME: &'static str = stringify!(#ident);
+        )
+    };
+
+    let expanded = quote! {
+        impl #impl_generics ::prost::MessageView<#lifetime> for #ident #ty_generics #where_clause {
+            #[allow(unused_variables)]
+            fn merge_field(
+                &mut self,
+                tag: u32,
+                wire_type: ::prost::encoding::WireType,
+                buf: &mut &#lifetime [u8],
+                ctx: ::prost::encoding::DecodeContext,
+            ) -> ::core::result::Result<(), ::prost::DecodeError>
+            {
+                #struct_name
+                match tag {
+                    #(#merge)*
+                    _ => {
+                        ::prost::instrument::unknown_field::<Self>(tag, wire_type);
+                        ::prost::instrument::skip_field::<Self>(wire_type, tag, buf, ctx)
+                    }
+                }
+            }
+        }
+    };
+
+    Ok(expanded)
+}
+
+#[proc_macro_derive(MessageView, attributes(prost))]
+pub fn message_view(input: proc_macro::TokenStream) -> proc_macro::TokenStream {
+    try_message_view(input.into()).unwrap().into()
+}
+
 fn try_enumeration(input: TokenStream) -> Result<TokenStream, Error> {
     let input: DeriveInput = syn::parse2(input)?;
     let ident = input.ident;
@@ -462,7 +1137,7 @@ fn try_oneof(input: TokenStream) -> Result<TokenStream, Error> {
     let expanded = quote! {
         impl #impl_generics #ident #ty_generics #where_clause {
             /// Encodes the message to a buffer.
-            pub fn encode(&self, buf: &mut impl ::prost::bytes::BufMut) {
+            pub fn encode(&self, buf: &mut (impl ::prost::encoding::EncodeBuf + ?Sized)) {
                 match *self {
                     #(#encode,)*
                 }
@@ -473,7 +1148,7 @@ fn try_oneof(input: TokenStream) -> Result<TokenStream, Error> {
                 field: &mut ::core::option::Option<#ident #ty_generics>,
                 tag: u32,
                 wire_type: ::prost::encoding::WireType,
-                buf: &mut impl ::prost::bytes::Buf,
+                buf: &mut (impl ::prost::encoding::DecodeBuf + ?Sized),
                 ctx: ::prost::encoding::DecodeContext,
             ) -> ::core::result::Result<(), ::prost::DecodeError>
             {
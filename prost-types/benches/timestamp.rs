@@ -0,0 +1,190 @@
+use std::time::{SystemTime, UNIX_EPOCH};
+
+use criterion::{Criterion, Throughput};
+use prost_types::{Duration, Timestamp};
+
+/// 1,000 timestamps of recent dates, a quarter of them with each precision of subseconds.
+fn timestamps() -> Vec<Timestamp> {
+    (0..1_000i64)
+        .map(|i| {
+            let nanos = match i % 4 {
+                0 => 0,
+                1 => 123_000_000,
+                2 => 123_456_000,
+                _ => 123_456_789,
+            };
+            Timestamp {
+                seconds: 1_700_000_000 + i * 86_413,
+                nanos,
+            }
+        })
+        .collect()
+}
+
+fn benchmark_format(criterion: &mut Criterion) {
+    let timestamps = timestamps();
+    let durations = timestamps
+        .iter()
+        .map(|timestamp| Duration {
+            seconds: timestamp.seconds % 100_000,
+            nanos: timestamp.nanos,
+        })
+        .collect::<Vec<_>>();
+
+    criterion
+        .benchmark_group("timestamp/format")
+        .bench_function("format_into", {
+            let timestamps = timestamps.clone();
+            move |b| {
+                let mut buf = [0; Timestamp::MAX_FORMATTED_LEN];
+                b.iter(|| {
+                    for timestamp in &timestamps {
+                        criterion::black_box(timestamp.format_into(&mut buf));
+                    }
+                })
+            }
+        })
+        .throughput(Throughput::Elements(timestamps.len() as u64));
+
+    criterion
+        .benchmark_group("timestamp/format")
+        .bench_function("to_string", {
+            let timestamps = timestamps.clone();
+            move |b| {
+                b.iter(|| {
+                    for timestamp in &timestamps {
+                        criterion::black_box(timestamp.to_string());
+                    }
+                })
+            }
+        })
+        .throughput(Throughput::Elements(timestamps.len() as u64));
+
+    criterion
+        .benchmark_group("duration/format")
+        .bench_function("format_into", {
+            let durations = durations.clone();
+            move |b| {
+                let mut buf = [0; Duration::MAX_FORMATTED_LEN];
+                b.iter(|| {
+                    for duration in &durations {
+                        criterion::black_box(duration.format_into(&mut buf));
+                    }
+                })
+            }
+        })
+        .throughput(Throughput::Elements(durations.len() as u64));
+}
+
+fn benchmark_parse(criterion: &mut Criterion, name: &str, strings: Vec<String>) {
+    let len = strings.len() as u64;
+    criterion
+        .benchmark_group(format!("timestamp/parse/{}", name))
+        .bench_function("from_str", move |b| {
+            b.iter(|| {
+                for string in &strings {
+                    let result = string.parse::<Timestamp>();
+                    debug_assert!(result.is_ok());
+                    criterion::black_box(&result);
+                }
+            })
+        })
+        .throughput(Throughput::Elements(len));
+}
+
+fn benchmark_convert(criterion: &mut Criterion) {
+    let timestamps = timestamps();
+    let nanos = timestamps
+        .iter()
+        .map(|timestamp| timestamp.to_unix_nanos().unwrap())
+        .collect::<Vec<_>>();
+    let system_times = timestamps
+        .iter()
+        .map(|&timestamp| SystemTime::try_from(timestamp).unwrap())
+        .collect::<Vec<_>>();
+    let len = timestamps.len() as u64;
+
+    criterion
+        .benchmark_group("timestamp/unix_nanos")
+        .bench_function("from_unix_nanos_slice", {
+            let nanos = nanos.clone();
+            move |b| {
+                let mut converted = vec![Timestamp::default(); nanos.len()];
+                b.iter(|| {
+                    Timestamp::from_unix_nanos_slice(&nanos, &mut converted);
+                    criterion::black_box(&converted);
+                })
+            }
+        })
+        .throughput(Throughput::Elements(len));
+
+    criterion
+        .benchmark_group("timestamp/unix_nanos")
+        .bench_function("to_unix_nanos_slice", {
+            let timestamps = timestamps.clone();
+            move |b| {
+                let mut converted = vec![0; timestamps.len()];
+                b.iter(|| {
+                    let result = Timestamp::to_unix_nanos_slice(&timestamps, &mut converted);
+                    debug_assert!(result.is_ok());
+                    criterion::black_box(&converted);
+                })
+            }
+        })
+        .throughput(Throughput::Elements(len));
+
+    criterion
+        .benchmark_group("timestamp/system_time")
+        .bench_function("from_system_time_slice", {
+            let system_times = system_times.clone();
+            move |b| {
+                let mut converted = vec![Timestamp::default(); system_times.len()];
+                b.iter(|| {
+                    Timestamp::from_system_time_slice(&system_times, &mut converted);
+                    criterion::black_box(&converted);
+                })
+            }
+        })
+        .throughput(Throughput::Elements(len));
+
+    criterion
+        .benchmark_group("timestamp/system_time")
+        .bench_function("to_system_time_slice", move |b| {
+            let mut converted = vec![UNIX_EPOCH; timestamps.len()];
+            b.iter(|| {
+                let result = Timestamp::to_system_time_slice(&timestamps, &mut converted);
+                debug_assert!(result.is_ok());
+                criterion::black_box(&converted);
+            })
+        })
+        .throughput(Throughput::Elements(len));
+}
+
+fn main() {
+    let mut criterion = Criterion::default().configure_from_args();
+
+    // Benchmark formatting timestamps and durations, without and with allocating strings.
+    benchmark_format(&mut criterion);
+
+    // Benchmark parsing timestamps in the common `Z` form, which takes the fast path.
+    benchmark_parse(
+        &mut criterion,
+        "utc",
+        timestamps().iter().map(Timestamp::to_string).collect(),
+    );
+
+    // Benchmark parsing timestamps with an offset, which takes the general path.
+    benchmark_parse(
+        &mut criterion,
+        "offset",
+        timestamps()
+            .iter()
+            .map(|timestamp| timestamp.to_string().replace('Z', "+01:00"))
+            .collect(),
+    );
+
+    // Benchmark converting timestamps from and to nanoseconds and system times.
+    benchmark_convert(&mut criterion);
+
+    criterion.final_summary();
+}
@@ -1,15 +1,17 @@
 use super::*;
 
+use prost::bytes::Bytes;
+
 impl Any {
     /// Serialize the given message type `M` as [`Any`].
     pub fn from_msg<M>(msg: &M) -> Result<Self, EncodeError>
     where
         M: Name,
     {
-        let type_url = M::type_url();
-        let mut value = Vec::new();
-        Message::encode(msg, &mut value)?;
-        Ok(Any { type_url, value })
+        Ok(Any {
+            type_url: M::type_url(),
+            value: msg.encode_to_vec(),
+        })
     }
 
     /// Decode the given message type `M` from [`Any`], validating that it has
@@ -18,33 +20,89 @@ impl Any {
     where
         M: Default + Name + Sized,
     {
-        let expected_type_url = M::type_url();
-
-        if let (Some(expected), Some(actual)) = (
-            TypeUrl::new(&expected_type_url),
-            TypeUrl::new(&self.type_url),
-        ) {
-            if expected == actual {
-                return M::decode(self.value.as_slice());
-            }
-        }
-
-        let mut err = DecodeError::new(format!(
-            "expected type URL: \"{}\" (got: \"{}\")",
-            expected_type_url, &self.type_url
-        ));
-        err.push("unexpected type URL", "type_url");
-        Err(err)
+        check_type_url::<M>(&self.type_url)?;
+        M::decode(self.value.as_slice())
     }
 }
 
 impl Name for Any {
     const PACKAGE: &'static str = PACKAGE;
     const NAME: &'static str = "Any";
+    const TYPE_URL: core::option::Option<&'static str> =
+        core::option::Option::Some("type.googleapis.com/google.protobuf.Any");
+}
+
+/// [`Any`], with its value stored as [`Bytes`].
+///
+/// It is encoded exactly like `Any`. Decoding it from a `Bytes` buffer shares the buffer instead
+/// of copying the value, and unpacking it with [`to_msg`](SharedAny::to_msg) shares the value
+/// with the `bytes::Bytes` fields of the message, so that large payloads are never copied.
+#[derive(Clone, PartialEq, Message)]
+pub struct SharedAny {
+    /// A URL/resource name that uniquely identifies the type of the serialized
+    /// protocol buffer message, as in [`Any::type_url`].
+    #[prost(string, tag = "1")]
+    pub type_url: String,
+    /// Must be a valid serialized protocol buffer of the above specified type.
+    #[prost(bytes = "bytes", tag = "2")]
+    pub value: Bytes,
+}
+
+impl SharedAny {
+    /// Serialize the given message type `M` as [`SharedAny`].
+    pub fn from_msg<M>(msg: &M) -> Result<Self, EncodeError>
+    where
+        M: Name,
+    {
+        Ok(SharedAny {
+            type_url: M::type_url(),
+            value: msg.encode_to_vec().into(),
+        })
+    }
+
+    /// Decode the given message type `M` from [`SharedAny`], validating that it has
+    /// the expected type URL.
+    pub fn to_msg<M>(&self) -> Result<M, DecodeError>
+    where
+        M: Default + Name + Sized,
+    {
+        check_type_url::<M>(&self.type_url)?;
+        M::decode(self.value.clone())
+    }
+}
 
-    fn type_url() -> String {
-        type_url_for::<Self>()
+impl From<Any> for SharedAny {
+    /// Converts an [`Any`] into a [`SharedAny`], without copying its value.
+    fn from(any: Any) -> SharedAny {
+        SharedAny {
+            type_url: any.type_url,
+            value: any.value.into(),
+        }
+    }
+}
+
+/// Returns an error unless `type_url` identifies the message type `M`.
+fn check_type_url<M: Name>(type_url: &str) -> Result<(), DecodeError> {
+    // The type URL is usually exactly the expected one, which is compared without parsing it.
+    if M::TYPE_URL == Some(type_url) {
+        return Ok(());
+    }
+
+    let expected_type_url = M::type_url();
+    if let (Some(expected), Some(actual)) =
+        (TypeUrl::new(&expected_type_url), TypeUrl::new(type_url))
+    {
+        if expected == actual {
+            return Ok(());
+        }
     }
+
+    let mut err = DecodeError::new(format!(
+        "expected type URL: \"{}\" (got: \"{}\")",
+        expected_type_url, type_url
+    ));
+    err.push("unexpected type URL", "type_url");
+    Err(err)
 }
 
 #[cfg(test)]
@@ -65,5 +123,32 @@ mod tests {
 
         // Wrong type URL
         assert!(any.to_msg::<Duration>().is_err());
+
+        // Type URLs with another authority identify the same type.
+        let any = Any {
+            type_url: "example.com/google.protobuf.Timestamp".into(),
+            ..any
+        };
+        assert_eq!(any.to_msg::<Timestamp>().unwrap(), message);
+    }
+
+    #[test]
+    fn check_shared_any_serialization() {
+        let message = Duration {
+            seconds: 10,
+            nanos: 5,
+        };
+        let any = SharedAny::from_msg(&message).unwrap();
+        assert_eq!(
+            any.encode_to_vec(),
+            Any::from_msg(&message).unwrap().encode_to_vec()
+        );
+        assert_eq!(any.to_msg::<Duration>().unwrap(), message);
+        assert!(any.to_msg::<Timestamp>().is_err());
+
+        let encoded = Bytes::from(any.encode_to_vec());
+        let decoded = SharedAny::decode(encoded.clone()).unwrap();
+        assert_eq!(decoded, any);
+        assert!(encoded.as_ptr_range().contains(&decoded.value.as_ptr()));
     }
 }
@@ -1,5 +1,5 @@
-//! A date/time type which exists primarily to convert [`Timestamp`]s into an RFC 3339 formatted
-//! string.
+//! The formatting and parsing of timestamps and durations, with a date/time type which exists
+//! primarily to convert [`Timestamp`]s into an RFC 3339 formatted string.
 
 use core::fmt;
 
@@ -65,119 +65,178 @@ impl DateTime {
 
 impl fmt::Display for DateTime {
     fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        let mut buf = [0; MAX_TIMESTAMP_LEN];
+        let len = self.write(&mut buf);
+        f.write_str(ascii_str(&buf[..len]))
+    }
+}
+
+/// The maximum length of a formatted `DateTime`, which is that of
+/// `+292277026596-12-04T15:30:07.999999999Z`.
+pub(crate) const MAX_TIMESTAMP_LEN: usize = 39;
+
+/// The maximum length of a formatted `Duration`, which is that of
+/// `-9223372036854775808.999999999s`.
+pub(crate) const MAX_DURATION_LEN: usize = 31;
+
+impl DateTime {
+    /// Writes the date time in RFC 3339 format to the start of `buf`, returning the length of the
+    /// formatted date time.
+    pub(crate) fn write(&self, buf: &mut [u8; MAX_TIMESTAMP_LEN]) -> usize {
         // Pad years to at least 4 digits.
-        if self.year > 9999 {
-            write!(f, "+{}", self.year)?;
-        } else if self.year < 0 {
-            write!(f, "{:05}", self.year)?;
+        let len = if (0..=9999).contains(&self.year) {
+            let year = self.year as u32;
+            write_two_digits(&mut buf[0..2], year / 100);
+            write_two_digits(&mut buf[2..4], year % 100);
+            4
         } else {
-            write!(f, "{:04}", self.year)?;
+            buf[0] = if self.year < 0 { b'-' } else { b'+' };
+            1 + write_digits(&mut buf[1..], self.year.unsigned_abs(), 4)
         };
 
-        write!(
-            f,
-            "-{:02}-{:02}T{:02}:{:02}:{:02}",
-            self.month, self.day, self.hour, self.minute, self.second,
-        )?;
-
-        // Format subseconds to either nothing, millis, micros, or nanos.
-        let nanos = self.nanos;
-        if nanos == 0 {
-            write!(f, "Z")
-        } else if nanos % 1_000_000 == 0 {
-            write!(f, ".{:03}Z", nanos / 1_000_000)
-        } else if nanos % 1_000 == 0 {
-            write!(f, ".{:06}Z", nanos / 1_000)
-        } else {
-            write!(f, ".{:09}Z", nanos)
-        }
+        let time = &mut buf[len..len + 15];
+        time.copy_from_slice(b"-00-00T00:00:00");
+        write_two_digits(&mut time[1..3], u32::from(self.month));
+        write_two_digits(&mut time[4..6], u32::from(self.day));
+        write_two_digits(&mut time[7..9], u32::from(self.hour));
+        write_two_digits(&mut time[10..12], u32::from(self.minute));
+        write_two_digits(&mut time[13..15], u32::from(self.second));
+        let len = len + 15;
+
+        let len = len + write_nanos(&mut buf[len..], self.nanos);
+        buf[len] = b'Z';
+        len + 1
+    }
+}
+
+/// Writes a normalized duration in the [Protobuf JSON encoding spec format][1] to the start of
+/// `buf`, returning the length of the formatted duration.
+///
+/// [1]: https://developers.google.com/protocol-buffers/docs/proto3#json
+pub(crate) fn write_duration(duration: &Duration, buf: &mut [u8; MAX_DURATION_LEN]) -> usize {
+    let negative = duration.seconds < 0 || duration.nanos < 0;
+    buf[0] = b'-';
+    let len = usize::from(negative);
+    let len = len + write_digits(&mut buf[len..], duration.seconds.unsigned_abs(), 1);
+    let len = len + write_nanos(&mut buf[len..], duration.nanos.unsigned_abs());
+    buf[len] = b's';
+    len + 1
+}
+
+/// Writes the two least significant decimal digits of `value` to `buf`.
+#[inline]
+fn write_two_digits(buf: &mut [u8], value: u32) {
+    buf[0] = b'0' + (value / 10 % 10) as u8;
+    buf[1] = b'0' + (value % 10) as u8;
+}
+
+/// Writes `value` in decimal to the start of `buf`, padded with zeros to at least `min_digits`
+/// digits, returning the number of written digits.
+fn write_digits(buf: &mut [u8], mut value: u64, min_digits: usize) -> usize {
+    let mut digits = [b'0'; 20];
+    let mut start = digits.len();
+    while value > 0 {
+        start -= 1;
+        digits[start] = b'0' + (value % 10) as u8;
+        value /= 10;
     }
+    let start = start.min(digits.len() - min_digits);
+    let len = digits.len() - start;
+    buf[..len].copy_from_slice(&digits[start..]);
+    len
+}
+
+/// Writes the subseconds of `nanos` to the start of `buf`, as either nothing, millis, micros, or
+/// nanos, returning the number of written bytes.
+#[inline]
+fn write_nanos(buf: &mut [u8], nanos: u32) -> usize {
+    // All nine digits are written, and the trailing zeros are then left out.
+    let fraction = &mut buf[..10];
+    fraction[0] = b'.';
+    write_two_digits(&mut fraction[1..3], nanos / 10_000_000);
+    write_two_digits(&mut fraction[3..5], nanos / 100_000);
+    write_two_digits(&mut fraction[5..7], nanos / 1_000);
+    write_two_digits(&mut fraction[7..9], nanos / 10);
+    fraction[9] = b'0' + (nanos % 10) as u8;
+
+    if nanos == 0 {
+        0
+    } else if nanos % 1_000_000 == 0 {
+        4
+    } else if nanos % 1_000 == 0 {
+        7
+    } else {
+        10
+    }
+}
+
+/// Returns the formatted ASCII bytes as a string.
+pub(crate) fn ascii_str(bytes: &[u8]) -> &str {
+    debug_assert!(bytes.is_ascii());
+    // Safety: the formatting functions only write ASCII characters.
+    unsafe { core::str::from_utf8_unchecked(bytes) }
 }
 
 impl From<Timestamp> for DateTime {
-    /// musl's [`__secs_to_tm`][1] converted to Rust via [c2rust][2] and then cleaned up by hand.
+    /// Howard Hinnant's [`civil_from_days`][1], which converts days to a date without loops or
+    /// data-dependent branches.
     ///
     /// All existing `strftime`-like APIs in Rust are unable to handle the full range of timestamps
     /// representable by `Timestamp`, including `strftime` itself, since tm.tm_year is an int.
     ///
-    /// [1]: http://git.musl-libc.org/cgit/musl/tree/src/time/__secs_to_tm.c
-    /// [2]: https://c2rust.com/
+    /// [1]: https://howardhinnant.github.io/date_algorithms.html#civil_from_days
     fn from(mut timestamp: Timestamp) -> DateTime {
         timestamp.normalize();
 
-        let t = timestamp.seconds;
-        let nanos = timestamp.nanos;
-
-        // 2000-03-01 (mod 400 year, immediately after feb29
-        const LEAPOCH: i64 = 946_684_800 + 86400 * (31 + 29);
-        const DAYS_PER_400Y: i32 = 365 * 400 + 97;
-        const DAYS_PER_100Y: i32 = 365 * 100 + 24;
-        const DAYS_PER_4Y: i32 = 365 * 4 + 1;
-        const DAYS_IN_MONTH: [u8; 12] = [31, 30, 31, 30, 31, 31, 30, 31, 30, 31, 31, 29];
-
-        // Note(dcb): this bit is rearranged slightly to avoid integer overflow.
-        let mut days: i64 = (t / 86_400) - (LEAPOCH / 86_400);
-        let mut remsecs: i32 = (t % 86_400) as i32;
-        if remsecs < 0i32 {
-            remsecs += 86_400;
-            days -= 1
-        }
-
-        let mut qc_cycles: i32 = (days / i64::from(DAYS_PER_400Y)) as i32;
-        let mut remdays: i32 = (days % i64::from(DAYS_PER_400Y)) as i32;
-        if remdays < 0 {
-            remdays += DAYS_PER_400Y;
-            qc_cycles -= 1;
-        }
-
-        let mut c_cycles: i32 = remdays / DAYS_PER_100Y;
-        if c_cycles == 4 {
-            c_cycles -= 1;
-        }
-        remdays -= c_cycles * DAYS_PER_100Y;
-
-        let mut q_cycles: i32 = remdays / DAYS_PER_4Y;
-        if q_cycles == 25 {
-            q_cycles -= 1;
-        }
-        remdays -= q_cycles * DAYS_PER_4Y;
-
-        let mut remyears: i32 = remdays / 365;
-        if remyears == 4 {
-            remyears -= 1;
-        }
-        remdays -= remyears * 365;
-
-        let mut years: i64 = i64::from(remyears)
-            + 4 * i64::from(q_cycles)
-            + 100 * i64::from(c_cycles)
-            + 400 * i64::from(qc_cycles);
-
-        let mut months: i32 = 0;
-        while i32::from(DAYS_IN_MONTH[months as usize]) <= remdays {
-            remdays -= i32::from(DAYS_IN_MONTH[months as usize]);
-            months += 1
-        }
-
-        if months >= 10 {
-            months -= 12;
-            years += 1;
-        }
+        let days = timestamp.seconds.div_euclid(86_400);
+        let secs_of_day = timestamp.seconds.rem_euclid(86_400) as u32;
+
+        // Shift the epoch to 0000-03-01, so that leap days are at the end of the year.
+        let days = days + 719_468;
+        let era = days.div_euclid(146_097);
+        let day_of_era = days.rem_euclid(146_097) as u32;
+        let year_of_era =
+            (day_of_era - day_of_era / 1_460 + day_of_era / 36_524 - day_of_era / 146_096) / 365;
+        let day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+        // The month, counted from March.
+        let month = (5 * day_of_year + 2) / 153;
+        let day = day_of_year - (153 * month + 2) / 5 + 1;
+        let month = if month < 10 { month + 3 } else { month - 9 };
+        let year = i64::from(year_of_era) + era * 400 + i64::from(month <= 2);
 
         let date_time = DateTime {
-            year: years + 2000,
-            month: (months + 3) as u8,
-            day: (remdays + 1) as u8,
-            hour: (remsecs / 3600) as u8,
-            minute: (remsecs / 60 % 60) as u8,
-            second: (remsecs % 60) as u8,
-            nanos: nanos as u32,
+            year,
+            month: month as u8,
+            day: day as u8,
+            hour: (secs_of_day / 3600) as u8,
+            minute: (secs_of_day / 60 % 60) as u8,
+            second: (secs_of_day % 60) as u8,
+            nanos: timestamp.nanos as u32,
         };
         debug_assert!(date_time.is_valid());
         date_time
     }
 }
 
+/// Returns the number of days from the Unix epoch to a date of a year from 0 to 9999.
+///
+/// This is Howard Hinnant's [`days_from_civil`][1] for the years which can be parsed by
+/// `parse_timestamp_fast`, which do not overflow.
+///
+/// [1]: https://howardhinnant.github.io/date_algorithms.html#days_from_civil
+fn days_from_civil(year: u32, month: u32, day: u32) -> i64 {
+    debug_assert!(year <= 9999);
+
+    // Count years from March, starting at year -1, so that leap days are at the end of the year.
+    let year = year + 400 - u32::from(month <= 2);
+    let era = year / 400;
+    let year_of_era = year % 400;
+    let month = if month > 2 { month - 3 } else { month + 9 };
+    let day_of_year = (153 * month + 2) / 5 + day - 1;
+    let day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    i64::from(era * 146_097 + day_of_era) - 146_097 - 719_468
+}
+
 /// Returns the number of days in the month.
 fn days_in_month(year: i64, month: u8) -> u8 {
     const DAYS_IN_MONTH: [u8; 12] = [31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31];
@@ -481,8 +540,100 @@ pub(crate) fn year_to_seconds(year: i64) -> (i128, bool) {
     )
 }
 
+/// Parses a timestamp in the most common RFC 3339 form, `YYYY-MM-DDTHH:MM:SS[.fffffffff]Z`,
+/// directly from the bytes of `s`.
+///
+/// Returns `None` for any other form, which is left to the general parser.
+fn parse_timestamp_fast(s: &[u8]) -> Option<Timestamp> {
+    // The fraction has at most 9 digits.
+    ensure!(s.len() >= 20 && s.len() <= 30);
+    let (date_time, rest) = s.split_at(19);
+    ensure!(
+        date_time[4] == b'-'
+            && date_time[7] == b'-'
+            && date_time[10] == b'T'
+            && date_time[13] == b':'
+            && date_time[16] == b':'
+    );
+    let year = parse_two_digits(&date_time[0..2])? * 100 + parse_two_digits(&date_time[2..4])?;
+    let month = parse_two_digits(&date_time[5..7])?;
+    let day = parse_two_digits(&date_time[8..10])?;
+    let hour = parse_two_digits(&date_time[11..13])?;
+    let minute = parse_two_digits(&date_time[14..16])?;
+    let second = parse_two_digits(&date_time[17..19])?;
+
+    let nanos = match rest {
+        [b'Z'] => 0,
+        [b'.', digits @ .., b'Z'] if !digits.is_empty() => {
+            // The nanos of each number of fractional digits.
+            const SCALE: [u32; 10] = [
+                0,
+                100_000_000,
+                10_000_000,
+                1_000_000,
+                100_000,
+                10_000,
+                1_000,
+                100,
+                10,
+                1,
+            ];
+
+            // The digits are checked all at once, after the loop, so the nanos of invalid digits
+            // can wrap around.
+            let mut nanos: u32 = 0;
+            let mut invalid = false;
+            for &c in digits {
+                let digit = c.wrapping_sub(b'0');
+                invalid |= digit > 9;
+                nanos = nanos.wrapping_mul(10).wrapping_add(u32::from(digit));
+            }
+            ensure!(!invalid);
+            nanos * SCALE[digits.len()]
+        }
+        _ => return None,
+    };
+
+    const DAYS_IN_MONTH: [u8; 12] = [31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31];
+    ensure!((1..=12).contains(&month));
+    let is_leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    let days_in_month =
+        u32::from(DAYS_IN_MONTH[month as usize - 1]) + u32::from(is_leap && month == 2);
+    ensure!(day >= 1 && day <= days_in_month && hour < 24 && minute < 60 && second <= 60);
+
+    // Roll leap seconds back to the previous second, like `parse_timestamp`.
+    let second = second.min(59);
+    let seconds =
+        days_from_civil(year, month, day) * 86_400 + i64::from(hour * 3600 + minute * 60 + second);
+    Some(Timestamp {
+        seconds,
+        nanos: nanos as i32,
+    })
+}
+
+/// Parses the ASCII decimal digit `c`.
+#[inline]
+fn parse_digit(c: u8) -> Option<u32> {
+    let digit = c.wrapping_sub(b'0');
+    if digit < 10 {
+        Some(u32::from(digit))
+    } else {
+        None
+    }
+}
+
+/// Parses two ASCII decimal digits.
+#[inline]
+fn parse_two_digits(s: &[u8]) -> Option<u32> {
+    Some(parse_digit(s[0])? * 10 + parse_digit(s[1])?)
+}
+
 /// Parses a timestamp in RFC 3339 format from `s`.
 pub(crate) fn parse_timestamp(s: &str) -> Option<Timestamp> {
+    if let Some(timestamp) = parse_timestamp_fast(s.as_bytes()) {
+        return Some(timestamp);
+    }
+
     // Check that the string is ASCII, since subsequent parsing steps use byte-level indexing.
     ensure!(s.is_ascii());
 
@@ -771,6 +922,91 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_parse_timestamp_fast() {
+        let case = |s: &str, expected: Option<Timestamp>| {
+            assert_eq!(
+                parse_timestamp_fast(s.as_bytes()),
+                expected,
+                "timestamp: {}",
+                s
+            );
+            // The fast parser agrees with the general parser on what it parses.
+            if let Some(expected) = expected {
+                assert_eq!(s.parse::<Timestamp>(), Ok(expected), "timestamp: {}", s);
+            }
+        };
+
+        case("1970-01-01T00:00:00Z", Some(Timestamp::default()));
+        case(
+            "1985-04-12T23:20:50.52Z",
+            Timestamp::date_time_nanos(1985, 4, 12, 23, 20, 50, 520_000_000).ok(),
+        );
+        case(
+            "2020-02-29T01:02:03.123456789Z",
+            Timestamp::date_time_nanos(2020, 2, 29, 1, 2, 3, 123_456_789).ok(),
+        );
+        case(
+            "0000-01-01T00:00:00.000000001Z",
+            Timestamp::date_time_nanos(0, 1, 1, 0, 0, 0, 1).ok(),
+        );
+        case(
+            "9999-12-31T23:59:59.999Z",
+            Timestamp::date_time_nanos(9999, 12, 31, 23, 59, 59, 999_000_000).ok(),
+        );
+        case(
+            "1990-12-31T23:59:60Z",
+            Timestamp::date_time(1990, 12, 31, 23, 59, 59).ok(),
+        );
+
+        // Other forms are left to the general parser.
+        case("1985-04-12T23:20:50.52z", None);
+        case("1985-04-12t23:20:50.52Z", None);
+        case("1985-04-12 23:20:50.52Z", None);
+        case("1985-04-12T23:20:50.52", None);
+        case("1985-04-12T23:20:50.52+00:00", None);
+        case("1985-04-12", None);
+        case("+19370-01-01T00:00:00Z", None);
+
+        // Invalid timestamps.
+        case("1985-04-12T23:20:50.Z", None);
+        case("1985-04-12T23:20:50.1234567890Z", None);
+        case("1985-04-12T23:20:50.12345678xZ", None);
+        case("1985-04-12T23:20:50.~~~~~~~~~Z", None);
+        case("1985-04-1xT23:20:50Z", None);
+        case("1985-13-12T23:20:50Z", None);
+        case("1900-02-29T00:00:00Z", None);
+        case("1985-04-31T00:00:00Z", None);
+        case("1985-04-12T24:00:00Z", None);
+        case("1985-04-12T23:60:00Z", None);
+        case("1985-04-12T23:00:61Z", None);
+    }
+
+    #[cfg(feature = "std")]
+    #[test]
+    fn test_format_duration() {
+        let case = |expected: &str, seconds: i64, nanos: i32| {
+            assert_eq!(
+                Duration { seconds, nanos }.to_string(),
+                expected,
+                "duration: {}s {}ns",
+                seconds,
+                nanos
+            );
+        };
+
+        case("0s", 0, 0);
+        case("1.500s", 1, 500_000_000);
+        case("0.000001s", 0, 1_000);
+        case("0.000000001s", 0, 1);
+        case("-1s", -1, 0);
+        case("-0.500s", 0, -500_000_000);
+        case("-1.500s", -1, -500_000_000);
+        case("-0.999999999s", -1, 1);
+        case("9223372036854775807.999999999s", i64::MAX, 999_999_999);
+        case("-9223372036854775808.999999999s", i64::MIN, -999_999_999);
+    }
+
     #[test]
     fn test_parse_duration() {
         let case = |s: &str, seconds: i64, nanos: i32| {
@@ -844,6 +1080,37 @@ mod tests {
             )
         }
 
+        #[cfg(feature = "std")]
+        #[test]
+        fn check_timestamp_format_into(
+            seconds in i64::arbitrary(),
+            nanos in 0i32..1_000_000_000,
+        ) {
+            let timestamp = Timestamp { seconds, nanos };
+            let mut buf = [0; Timestamp::MAX_FORMATTED_LEN];
+            let formatted = timestamp.format_into(&mut buf);
+            prop_assert_eq!(formatted.parse::<Timestamp>(), Ok(timestamp));
+            if let Some(fast) = parse_timestamp_fast(formatted.as_bytes()) {
+                prop_assert_eq!(fast, timestamp);
+            }
+        }
+
+        #[cfg(feature = "std")]
+        #[test]
+        fn check_duration_format_into(
+            seconds in i64::arbitrary(),
+            nanos in -999_999_999i32..1_000_000_000,
+        ) {
+            let mut duration = Duration { seconds, nanos };
+            duration.normalize();
+            let mut buf = [0; Duration::MAX_FORMATTED_LEN];
+            let formatted = duration.format_into(&mut buf);
+            // The parser does not accept the magnitude of `i64::MIN` seconds.
+            if seconds != i64::MIN {
+                prop_assert_eq!(formatted.parse::<Duration>(), Ok(duration));
+            }
+        }
+
         #[cfg(feature = "std")]
         #[test]
         fn check_duration_parse_to_string_roundtrip(
@@ -58,15 +58,30 @@ impl Duration {
         // debug_assert!(self.seconds >= -315_576_000_000 && self.seconds <= 315_576_000_000,
         //               "invalid duration: {:?}", self);
     }
+
+    /// The maximum length of a duration formatted by [`format_into`](Duration::format_into).
+    pub const MAX_FORMATTED_LEN: usize = datetime::MAX_DURATION_LEN;
+
+    /// Formats the normalized duration in the [Protobuf JSON encoding spec format][1] into `buf`,
+    /// returning the formatted string.
+    ///
+    /// The string is the same as that of the `Display` implementation, but is formatted without
+    /// allocating or going through a `fmt::Formatter`.
+    ///
+    /// [1]: https://developers.google.com/protocol-buffers/docs/proto3#json
+    pub fn format_into<'a>(&self, buf: &'a mut [u8; Duration::MAX_FORMATTED_LEN]) -> &'a str {
+        let mut duration = *self;
+        duration.normalize();
+        let len = datetime::write_duration(&duration, buf);
+        datetime::ascii_str(&buf[..len])
+    }
 }
 
 impl Name for Duration {
     const PACKAGE: &'static str = PACKAGE;
     const NAME: &'static str = "Duration";
-
-    fn type_url() -> String {
-        type_url_for::<Self>()
-    }
+    const TYPE_URL: core::option::Option<&'static str> =
+        core::option::Option::Some("type.googleapis.com/google.protobuf.Duration");
 }
 
 impl TryFrom<time::Duration> for Duration {
@@ -105,24 +120,8 @@ impl TryFrom<Duration> for time::Duration {
 
 impl fmt::Display for Duration {
     fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
-        let mut d = *self;
-        d.normalize();
-        if self.seconds < 0 && self.nanos < 0 {
-            write!(f, "-")?;
-        }
-        write!(f, "{}", d.seconds.abs())?;
-
-        // Format subseconds to either nothing, millis, micros, or nanos.
-        let nanos = d.nanos.abs();
-        if nanos == 0 {
-            write!(f, "s")
-        } else if nanos % 1_000_000 == 0 {
-            write!(f, ".{:03}s", nanos / 1_000_000)
-        } else if nanos % 1_000 == 0 {
-            write!(f, ".{:06}s", nanos / 1_000)
-        } else {
-            write!(f, ".{:09}s", nanos)
-        }
+        let mut buf = [0; Duration::MAX_FORMATTED_LEN];
+        f.write_str(self.format_into(&mut buf))
     }
 }
 
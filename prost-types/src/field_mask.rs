@@ -0,0 +1,62 @@
+use super::*;
+
+use prost::Projection;
+
+impl FieldMask {
+    /// Returns the projection which decodes the fields of the message `M` named by the paths of
+    /// the field mask.
+    ///
+    /// Returns an error if a path does not name a field of `M`.
+    pub fn projection<M>(&self) -> Result<Projection, DecodeError>
+    where
+        M: Message,
+    {
+        Projection::from_field_paths::<M, _>(&self.paths)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use prost::alloc::vec;
+
+    #[test]
+    fn check_field_mask_projection() {
+        let message = Type {
+            name: "Event".into(),
+            fields: vec![Field {
+                number: 1,
+                name: "id".into(),
+                ..Field::default()
+            }],
+            oneofs: vec!["kind".into()],
+            source_context: Some(SourceContext {
+                file_name: "event.proto".into(),
+            }),
+            ..Type::default()
+        };
+        let encoded = message.encode_to_vec();
+
+        let mask = FieldMask {
+            paths: vec!["name".into(), "fields.number".into()],
+        };
+        let projection = mask.projection::<Type>().unwrap();
+        let projected = Type::decode_projected(encoded.as_slice(), &projection).unwrap();
+        assert_eq!(
+            projected,
+            Type {
+                name: "Event".into(),
+                fields: vec![Field {
+                    number: 1,
+                    ..Field::default()
+                }],
+                ..Type::default()
+            }
+        );
+
+        let mask = FieldMask {
+            paths: vec!["name.length".into()],
+        };
+        assert!(mask.projection::<Type>().is_err());
+    }
+}
@@ -29,7 +29,6 @@ use core::time;
 
 use prost::alloc::format;
 use prost::alloc::string::String;
-use prost::alloc::vec::Vec;
 use prost::{DecodeError, EncodeError, Message, Name};
 
 pub use protobuf::*;
@@ -44,12 +43,21 @@ const NANOS_MAX: i32 = NANOS_PER_SECOND - 1;
 const PACKAGE: &str = "google.protobuf";
 
 mod any;
+pub use any::SharedAny;
 
 mod duration;
 pub use duration::DurationError;
 
+#[cfg(feature = "std")]
+mod field_mask;
+
+#[cfg(feature = "std")]
+mod registry;
+#[cfg(feature = "std")]
+pub use registry::TypeRegistry;
+
 mod timestamp;
 pub use timestamp::TimestampError;
 
 mod type_url;
-pub(crate) use type_url::{type_url_for, TypeUrl};
+pub(crate) use type_url::TypeUrl;
@@ -0,0 +1,188 @@
+use std::collections::HashMap;
+use std::hash::{BuildHasherDefault, Hasher};
+
+use prost::bytes::Bytes;
+
+use super::*;
+
+/// Decodes `Any` values of the type URLs it knows into values of type `T`, without knowing their
+/// type up front.
+///
+/// Every registered message type is identified by the full name in its type URL, so the
+/// authority of the type URL is ignored, as with [`Any::to_msg`]. The decoder of a type URL is
+/// found with a single hash lookup.
+///
+/// # Examples
+///
+/// ```rust
+/// use prost_types::{Any, Duration, Timestamp, TypeRegistry};
+///
+/// #[derive(Debug, PartialEq)]
+/// enum Event {
+///     Timeout(Duration),
+///     Alarm(Timestamp),
+/// }
+///
+/// let mut registry = TypeRegistry::new();
+/// registry
+///     .register(Event::Timeout)
+///     .register(Event::Alarm);
+///
+/// let timeout = Duration { seconds: 5, nanos: 0 };
+/// let any = Any::from_msg(&timeout).unwrap();
+/// assert_eq!(registry.decode(&any), Ok(Event::Timeout(timeout)));
+/// ```
+pub struct TypeRegistry<T> {
+    decoders: HashMap<String, Decoder<T>, BuildHasherDefault<FnvHasher>>,
+}
+
+/// The decoder of a registered message type, from the value of an [`Any`] and of a [`SharedAny`].
+struct Decoder<T> {
+    from_slice: Box<dyn Fn(&[u8]) -> Result<T, DecodeError> + Send + Sync>,
+    from_bytes: Box<dyn Fn(Bytes) -> Result<T, DecodeError> + Send + Sync>,
+}
+
+impl<T: 'static> TypeRegistry<T> {
+    /// Creates an empty registry.
+    pub fn new() -> TypeRegistry<T> {
+        TypeRegistry {
+            decoders: HashMap::default(),
+        }
+    }
+
+    /// Registers the message type `M`, whose decoded messages are converted with `convert`.
+    ///
+    /// Replaces any message type registered with the same full name.
+    pub fn register<M, F>(&mut self, convert: F) -> &mut TypeRegistry<T>
+    where
+        M: Default + Name + 'static,
+        F: Fn(M) -> T + Send + Sync + 'static,
+    {
+        let convert = std::sync::Arc::new(convert);
+        let convert_bytes = convert.clone();
+        self.decoders.insert(
+            M::full_name(),
+            Decoder {
+                from_slice: Box::new(move |value| M::decode(value).map(&*convert)),
+                from_bytes: Box::new(move |value| M::decode(value).map(&*convert_bytes)),
+            },
+        );
+        self
+    }
+
+    /// Returns whether a message type with the given type URL is registered.
+    pub fn contains(&self, type_url: &str) -> bool {
+        self.decoder(type_url).is_ok()
+    }
+
+    /// Decodes the value of `any`, with the decoder of its type URL.
+    pub fn decode(&self, any: &Any) -> Result<T, DecodeError> {
+        (self.decoder(&any.type_url)?.from_slice)(&any.value)
+    }
+
+    /// Decodes the value of `any`, with the decoder of its type URL.
+    ///
+    /// The `bytes::Bytes` fields of the decoded message share the value of `any`.
+    pub fn decode_shared(&self, any: &SharedAny) -> Result<T, DecodeError> {
+        (self.decoder(&any.type_url)?.from_bytes)(any.value.clone())
+    }
+
+    fn decoder(&self, type_url: &str) -> Result<&Decoder<T>, DecodeError> {
+        TypeUrl::new(type_url)
+            .and_then(|type_url| self.decoders.get(type_url.full_name))
+            .ok_or_else(|| {
+                let mut err = DecodeError::new(format!("unregistered type URL: \"{}\"", type_url));
+                err.push("Any", "type_url");
+                err
+            })
+    }
+}
+
+impl<T: 'static> Default for TypeRegistry<T> {
+    fn default() -> TypeRegistry<T> {
+        TypeRegistry::new()
+    }
+}
+
+impl<T> fmt::Debug for TypeRegistry<T> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_set().entries(self.decoders.keys()).finish()
+    }
+}
+
+/// The FNV-1a hash function, which hashes the short full names of message types faster than the
+/// default hasher of `HashMap`.
+///
+/// It does not resist collisions crafted by an attacker, which is not needed: only the full names
+/// of registered types are ever inserted, and looking up another name does not depend on its hash
+/// colliding with them.
+#[derive(Clone, Copy)]
+struct FnvHasher(u64);
+
+impl Default for FnvHasher {
+    fn default() -> FnvHasher {
+        FnvHasher(0xcbf2_9ce4_8422_2325)
+    }
+}
+
+impl Hasher for FnvHasher {
+    fn write(&mut self, bytes: &[u8]) {
+        for &byte in bytes {
+            self.0 = (self.0 ^ u64::from(byte)).wrapping_mul(0x0100_0000_01b3);
+        }
+    }
+
+    fn finish(&self) -> u64 {
+        self.0
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[derive(Debug, PartialEq)]
+    enum Value {
+        Duration(Duration),
+        Timestamp(Timestamp),
+    }
+
+    fn registry() -> TypeRegistry<Value> {
+        let mut registry = TypeRegistry::new();
+        registry
+            .register(Value::Duration)
+            .register(Value::Timestamp);
+        registry
+    }
+
+    #[test]
+    fn check_registry_decode() {
+        let registry = registry();
+        let duration = Duration {
+            seconds: 3,
+            nanos: 4,
+        };
+        let timestamp = Timestamp::date(2000, 1, 1).unwrap();
+
+        let any = Any::from_msg(&duration).unwrap();
+        assert_eq!(registry.decode(&any), Ok(Value::Duration(duration.clone())));
+        let any = SharedAny::from_msg(&timestamp).unwrap();
+        assert_eq!(
+            registry.decode_shared(&any),
+            Ok(Value::Timestamp(timestamp))
+        );
+
+        // The authority of the type URL is ignored.
+        assert!(registry.contains("type.googleapis.com/google.protobuf.Duration"));
+        assert!(registry.contains("/google.protobuf.Duration"));
+        assert!(!registry.contains("google.protobuf.Duration"));
+        assert!(!registry.contains("type.googleapis.com/google.protobuf.Any"));
+
+        let any = Any::from_msg(&Any::default()).unwrap();
+        assert_eq!(
+            registry.decode(&any).unwrap_err().to_string(),
+            "failed to decode Protobuf message: Any.type_url: \
+             unregistered type URL: \"type.googleapis.com/google.protobuf.Any\""
+        );
+    }
+}
@@ -105,15 +105,131 @@ impl Timestamp {
             Err(TimestampError::InvalidDateTime)
         }
     }
+
+    /// The maximum length of a timestamp formatted by [`format_into`](Timestamp::format_into).
+    pub const MAX_FORMATTED_LEN: usize = datetime::MAX_TIMESTAMP_LEN;
+
+    /// Formats the timestamp in RFC 3339 format into `buf`, returning the formatted string.
+    ///
+    /// The string is the same as that of the `Display` implementation, but is formatted without
+    /// allocating or going through a `fmt::Formatter`.
+    pub fn format_into<'a>(&self, buf: &'a mut [u8; Timestamp::MAX_FORMATTED_LEN]) -> &'a str {
+        let len = datetime::DateTime::from(*self).write(buf);
+        datetime::ascii_str(&buf[..len])
+    }
+
+    /// Creates a new `Timestamp` from a number of nanoseconds since the Unix epoch.
+    pub const fn from_unix_nanos(nanos: i64) -> Timestamp {
+        Timestamp {
+            seconds: nanos.div_euclid(NANOS_PER_SECOND as i64),
+            nanos: nanos.rem_euclid(NANOS_PER_SECOND as i64) as i32,
+        }
+    }
+
+    /// Returns the number of nanoseconds since the Unix epoch of the normalized timestamp.
+    ///
+    /// Fails if the timestamp is before 1677-09-21T00:12:43.145224192Z or after
+    /// 2262-04-11T23:47:16.854775807Z, which are out of the range of `i64` nanoseconds.
+    pub fn to_unix_nanos(&self) -> Result<i64, TimestampError> {
+        let mut timestamp = *self;
+        timestamp.normalize();
+        let nanos = i128::from(timestamp.seconds) * i128::from(NANOS_PER_SECOND)
+            + i128::from(timestamp.nanos);
+        i64::try_from(nanos).map_err(|_| TimestampError::OutOfNanosRange(*self))
+    }
+
+    /// Converts numbers of nanoseconds since the Unix epoch into `timestamps`, as with
+    /// [`from_unix_nanos`](Timestamp::from_unix_nanos).
+    ///
+    /// # Panics
+    ///
+    /// Panics if the two slices have different lengths.
+    pub fn from_unix_nanos_slice(nanos: &[i64], timestamps: &mut [Timestamp]) {
+        assert_eq!(nanos.len(), timestamps.len(), "slice lengths differ");
+        for (timestamp, &nanos) in timestamps.iter_mut().zip(nanos) {
+            *timestamp = Timestamp::from_unix_nanos(nanos);
+        }
+    }
+
+    /// Converts `timestamps` into numbers of nanoseconds since the Unix epoch, as with
+    /// [`to_unix_nanos`](Timestamp::to_unix_nanos).
+    ///
+    /// Returns the error of the first timestamp which is out of range, in which case the contents
+    /// of `nanos` are unspecified.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the two slices have different lengths.
+    pub fn to_unix_nanos_slice(
+        timestamps: &[Timestamp],
+        nanos: &mut [i64],
+    ) -> Result<(), TimestampError> {
+        assert_eq!(timestamps.len(), nanos.len(), "slice lengths differ");
+
+        // Seconds within this range can not overflow when their nanos are normalized.
+        const SECONDS: core::ops::RangeInclusive<i64> = -9_223_372_036..=9_223_372_035;
+
+        // Normalized timestamps are converted without any branch, and only checked at the end.
+        let mut normal = true;
+        for (nanos, timestamp) in nanos.iter_mut().zip(timestamps) {
+            normal &= SECONDS.contains(&timestamp.seconds)
+                && (0..NANOS_PER_SECOND).contains(&timestamp.nanos);
+            *nanos = timestamp
+                .seconds
+                .wrapping_mul(NANOS_PER_SECOND as i64)
+                .wrapping_add(timestamp.nanos as i64);
+        }
+
+        if !normal {
+            for (nanos, timestamp) in nanos.iter_mut().zip(timestamps) {
+                *nanos = timestamp.to_unix_nanos()?;
+            }
+        }
+        Ok(())
+    }
+
+    /// Converts system times into `timestamps`, as with `Timestamp::from`.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the two slices have different lengths.
+    #[cfg(feature = "std")]
+    pub fn from_system_time_slice(
+        system_times: &[std::time::SystemTime],
+        timestamps: &mut [Timestamp],
+    ) {
+        assert_eq!(system_times.len(), timestamps.len(), "slice lengths differ");
+        for (timestamp, &system_time) in timestamps.iter_mut().zip(system_times) {
+            *timestamp = Timestamp::from(system_time);
+        }
+    }
+
+    /// Converts `timestamps` into system times, as with `SystemTime::try_from`.
+    ///
+    /// Returns the error of the first timestamp which is out of range, in which case the contents
+    /// of `system_times` are unspecified.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the two slices have different lengths.
+    #[cfg(feature = "std")]
+    pub fn to_system_time_slice(
+        timestamps: &[Timestamp],
+        system_times: &mut [std::time::SystemTime],
+    ) -> Result<(), TimestampError> {
+        assert_eq!(timestamps.len(), system_times.len(), "slice lengths differ");
+        for (system_time, &timestamp) in system_times.iter_mut().zip(timestamps) {
+            *system_time = std::time::SystemTime::try_from(timestamp)?;
+        }
+        Ok(())
+    }
 }
 
 impl Name for Timestamp {
     const PACKAGE: &'static str = PACKAGE;
     const NAME: &'static str = "Timestamp";
-
-    fn type_url() -> String {
-        type_url_for::<Self>()
-    }
+    const TYPE_URL: core::option::Option<&'static str> =
+        core::option::Option::Some("type.googleapis.com/google.protobuf.Timestamp");
 }
 
 /// Implements the unstable/naive version of `Eq`: a basic equality check on the internal fields of the `Timestamp`.
@@ -166,6 +282,10 @@ pub enum TimestampError {
     /// `Timestamp`s.
     OutOfSystemRange(Timestamp),
 
+    /// Indicates that a [`Timestamp`] could not be converted to a number of nanoseconds since the
+    /// Unix epoch because it is out of the range of `i64`.
+    OutOfNanosRange(Timestamp),
+
     /// An error indicating failure to parse a timestamp in RFC-3339 format.
     ParseFailure,
 
@@ -183,6 +303,13 @@ impl fmt::Display for TimestampError {
                     timestamp
                 )
             }
+            TimestampError::OutOfNanosRange(timestamp) => {
+                write!(
+                    f,
+                    "{} is not representable as nanoseconds because it is out of range",
+                    timestamp
+                )
+            }
             TimestampError::ParseFailure => {
                 write!(f, "failed to parse RFC-3339 formatted timestamp")
             }
@@ -267,6 +394,115 @@ mod tests {
         }
     }
 
+    #[cfg(feature = "std")]
+    proptest! {
+        #[test]
+        fn check_unix_nanos_roundtrip(
+            nanos in i64::arbitrary(),
+        ) {
+            let timestamp = Timestamp::from_unix_nanos(nanos);
+            prop_assert!((0..NANOS_PER_SECOND).contains(&timestamp.nanos));
+            prop_assert_eq!(timestamp.to_unix_nanos(), Ok(nanos));
+        }
+
+        #[test]
+        fn check_unix_nanos_slice(
+            seconds in i64::arbitrary(),
+            nanos in i32::arbitrary(),
+        ) {
+            let timestamps = [
+                Timestamp::from_unix_nanos(seconds),
+                Timestamp { seconds, nanos },
+                Timestamp { seconds: seconds / 1_000_000_000, nanos },
+            ];
+            let mut converted = [0; 3];
+            let result = Timestamp::to_unix_nanos_slice(&timestamps, &mut converted);
+            let mut expected = [0; 3];
+            let expected = timestamps
+                .iter()
+                .zip(&mut expected)
+                .try_for_each(|(timestamp, expected)| {
+                    *expected = timestamp.to_unix_nanos()?;
+                    Ok(())
+                })
+                .map(|()| expected);
+            prop_assert_eq!(result.map(|()| converted), expected);
+        }
+    }
+
+    #[test]
+    fn check_unix_nanos() {
+        assert_eq!(
+            Timestamp::from_unix_nanos(-1),
+            Timestamp {
+                seconds: -1,
+                nanos: 999_999_999
+            }
+        );
+        assert_eq!(
+            Timestamp {
+                seconds: 1,
+                nanos: -1
+            }
+            .to_unix_nanos(),
+            Ok(999_999_999)
+        );
+
+        let mut buf = [0; Timestamp::MAX_FORMATTED_LEN];
+        let min = Timestamp::from_unix_nanos(i64::MIN);
+        assert_eq!(min.format_into(&mut buf), "1677-09-21T00:12:43.145224192Z");
+        let max = Timestamp::from_unix_nanos(i64::MAX);
+        assert_eq!(max.format_into(&mut buf), "2262-04-11T23:47:16.854775807Z");
+        let after_max = Timestamp {
+            seconds: max.seconds,
+            nanos: max.nanos + 1,
+        };
+        assert_eq!(
+            after_max.to_unix_nanos(),
+            Err(TimestampError::OutOfNanosRange(after_max))
+        );
+
+        let nanos = [i64::MIN, -1, 0, 1, i64::MAX];
+        let mut timestamps = [Timestamp::default(); 5];
+        Timestamp::from_unix_nanos_slice(&nanos, &mut timestamps);
+        assert_eq!(timestamps[0], min);
+        assert_eq!(timestamps[4], max);
+        let mut converted = [0; 5];
+        assert_eq!(
+            Timestamp::to_unix_nanos_slice(&timestamps, &mut converted),
+            Ok(())
+        );
+        assert_eq!(converted, nanos);
+
+        timestamps[2] = after_max;
+        assert_eq!(
+            Timestamp::to_unix_nanos_slice(&timestamps, &mut converted),
+            Err(TimestampError::OutOfNanosRange(after_max))
+        );
+    }
+
+    #[cfg(feature = "std")]
+    #[test]
+    fn check_system_time_slice() {
+        let timestamps = [
+            Timestamp::date(1969, 7, 20).unwrap(),
+            Timestamp::date_time_nanos(2000, 1, 1, 0, 0, 0, 100).unwrap(),
+        ];
+        let mut system_times = [UNIX_EPOCH; 2];
+        Timestamp::to_system_time_slice(&timestamps, &mut system_times).unwrap();
+        assert_eq!(
+            system_times,
+            [
+                SystemTime::try_from(timestamps[0]).unwrap(),
+                SystemTime::try_from(timestamps[1]).unwrap()
+            ]
+        );
+
+        let mut converted = [Timestamp::default(); 2];
+        Timestamp::from_system_time_slice(&system_times, &mut converted);
+        assert_eq!(converted, timestamps);
+    }
+
     #[cfg(feature = "std")]
     #[test]
     fn check_timestamp_negative_seconds() {
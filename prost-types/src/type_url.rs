@@ -1,5 +1,3 @@
-use super::*;
-
 /// URL/resource name that uniquely identifies the type of the serialized protocol buffer message,
 /// e.g. `type.googleapis.com/google.protobuf.Duration`.
 ///
@@ -37,12 +35,6 @@ impl<'a> TypeUrl<'a> {
     }
 }
 
-/// Compute the type URL for the given `google.protobuf` type, using `type.googleapis.com` as the
-/// authority for the URL.
-pub(crate) fn type_url_for<T: Name>() -> String {
-    format!("type.googleapis.com/{}.{}", T::PACKAGE, T::NAME)
-}
-
 #[cfg(test)]
 mod tests {
     use super::*;
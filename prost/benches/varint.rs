@@ -2,7 +2,9 @@ use std::mem;
 
 use bytes::Buf;
 use criterion::{Criterion, Throughput};
-use prost::encoding::{decode_varint, encode_varint, encoded_len_varint};
+use prost::encoding::{
+    decode_varint, encode_varint, encoded_len_varint, uint64, DecodeContext, WireType,
+};
 use rand::{rngs::StdRng, seq::SliceRandom, SeedableRng};
 
 fn benchmark_varint(criterion: &mut Criterion, name: &str, mut values: Vec<u64>) {
@@ -71,6 +73,36 @@ fn benchmark_varint(criterion: &mut Criterion, name: &str, mut values: Vec<u64>)
         .throughput(Throughput::Bytes(decoded_len));
 }
 
+fn benchmark_packed(criterion: &mut Criterion, name: &str, mut values: Vec<u64>) {
+    // Shuffle the values in a stable order.
+    values.shuffle(&mut StdRng::seed_from_u64(0));
+    let name = format!("packed/{}", name);
+
+    let mut buf = Vec::new();
+    uint64::encode_packed(1, &values, &mut buf);
+    // Skip the key, as `merge_repeated` expects the buffer to start at the length delimiter.
+    buf.remove(0);
+    let decoded_len = (values.len() * mem::size_of::<u64>()) as u64;
+
+    criterion
+        .benchmark_group(&name)
+        .bench_function("decode", move |b| {
+            let mut decoded = Vec::with_capacity(values.len());
+            b.iter(|| {
+                decoded.clear();
+                let result = uint64::merge_repeated(
+                    WireType::LengthDelimited,
+                    &mut decoded,
+                    &mut buf.as_slice(),
+                    DecodeContext::default(),
+                );
+                debug_assert!(result.is_ok());
+                criterion::black_box(&decoded);
+            })
+        })
+        .throughput(Throughput::Bytes(decoded_len));
+}
+
 fn main() {
     let mut criterion = Criterion::default().configure_from_args();
 
@@ -95,5 +127,24 @@ fn main() {
             .collect(),
     );
 
+    // Benchmark decoding a packed field of 10,000 small (1 byte) varints.
+    benchmark_packed(
+        &mut criterion,
+        "small",
+        (0..10_000).map(|i| i % 128).collect(),
+    );
+
+    // Benchmark decoding a packed field of 10,000 varints of mixed width (average 5.5 bytes).
+    benchmark_packed(
+        &mut criterion,
+        "mixed",
+        (0..10_000)
+            .map(|i: u64| (i % 100) + (1 << (i % 10 * 7)))
+            .collect(),
+    );
+
+    // Benchmark decoding a packed field of 10,000 large (10 byte) varints.
+    benchmark_packed(&mut criterion, "large", (1 << 63..).take(10_000).collect());
+
     criterion.final_summary();
 }
@@ -0,0 +1,184 @@
+//! Support for encoding many messages into a single length-delimited stream.
+
+#[cfg(not(feature = "std"))]
+use alloc::vec::Vec;
+
+use bytes::BufMut;
+
+use crate::encoding::{encode_varint, encoded_len_varint};
+use crate::{EncodeError, Message};
+
+/// The minimum number of messages encoded by each thread in
+/// [`encode_batch_length_delimited_parallel`]. Smaller batches are not worth the cost of starting
+/// a thread.
+#[cfg(feature = "std")]
+const MIN_MESSAGES_PER_THREAD: usize = 1024;
+
+/// Encodes a batch of messages, each with a length-delimiter, to the buffer.
+///
+/// The result is the same as calling [`Message::encode_length_delimited`] for each message, but
+/// the encoded lengths of all messages are computed in one pass first, and the capacity of the
+/// buffer is checked once for the whole batch. The messages are then written without further
+/// checks.
+///
+/// An error will be returned if the buffer does not have sufficient capacity for the whole batch,
+/// in which case nothing is written. This makes it possible to fill a buffer of bounded size, such
+/// as a network request, with whole batches. Buffers which grow on demand cannot run out of
+/// capacity: [`encode_batch_length_delimited_to_vec`] encodes into a `Vec` without computing the
+/// lengths separately.
+///
+/// # Examples
+///
+/// ```rust
+/// # use prost::Message;
+/// # #[derive(Message)]
+/// # struct Record {
+/// #     #[prost(uint64, tag = "1")]
+/// #     id: u64,
+/// # }
+/// let records = (0..100).map(|id| Record { id }).collect::<Vec<_>>();
+///
+/// let mut buf = Vec::new();
+/// prost::encode_batch_length_delimited(&records, &mut buf).unwrap();
+///
+/// let mut expected = Vec::new();
+/// for record in &records {
+///     record.encode_length_delimited(&mut expected).unwrap();
+/// }
+/// assert_eq!(buf, expected);
+/// ```
+pub fn encode_batch_length_delimited<M>(
+    messages: &[M],
+    buf: &mut impl BufMut,
+) -> Result<(), EncodeError>
+where
+    M: Message,
+{
+    let (lens, required) = sizes(messages);
+    encode_sized(messages.iter(), &lens, required, buf)
+}
+
+/// Encodes a batch of messages, each with a length-delimiter, to the buffer.
+///
+/// This is the same as [`encode_batch_length_delimited`], for messages which are not stored in a
+/// slice.
+pub fn encode_batch_length_delimited_iter<'a, M, I>(
+    messages: I,
+    buf: &mut impl BufMut,
+) -> Result<(), EncodeError>
+where
+    M: Message + 'a,
+    I: IntoIterator<Item = &'a M>,
+{
+    let messages = messages.into_iter().collect::<Vec<_>>();
+    let (lens, required) = sizes(messages.iter().copied());
+    encode_sized(messages.into_iter(), &lens, required, buf)
+}
+
+/// Encodes a batch of messages, each with a length-delimiter, to a newly allocated buffer.
+///
+/// Unlike [`Message::encode_length_delimited_to_vec`], which allocates a buffer for each message,
+/// all messages are written to a single buffer. Each message is written just after its encoded
+/// length is computed, while its fields are still in the cache.
+pub fn encode_batch_length_delimited_to_vec<M>(messages: &[M]) -> Vec<u8>
+where
+    M: Message,
+{
+    let mut buf = Vec::new();
+    for message in messages {
+        let len = message.encoded_len();
+        encode_varint(len as u64, &mut buf);
+        message.encode_raw(&mut buf);
+    }
+    buf
+}
+
+/// Encodes a batch of messages, each with a length-delimiter, to the buffer, encoding them in
+/// parallel.
+///
+/// The result is the same as with [`encode_batch_length_delimited`]. The batch is split between
+/// all available cores, and each thread encodes its messages into a buffer of its own. The
+/// buffers are then written to `buf` in order, after checking its capacity once. This pays off
+/// for large batches, or for messages which are expensive to encode, such as deeply nested
+/// messages. Small batches are encoded on the current thread.
+#[cfg(feature = "std")]
+pub fn encode_batch_length_delimited_parallel<M>(
+    messages: &[M],
+    buf: &mut impl BufMut,
+) -> Result<(), EncodeError>
+where
+    M: Message + Sync,
+{
+    let threads = std::thread::available_parallelism()
+        .map_or(1, std::num::NonZeroUsize::get)
+        .min(messages.len() / MIN_MESSAGES_PER_THREAD);
+    if threads <= 1 {
+        return encode_batch_length_delimited(messages, buf);
+    }
+
+    let chunk_len = (messages.len() + threads - 1) / threads;
+    let mut chunks = messages.chunks(chunk_len);
+    let first = chunks.next().unwrap();
+    let encoded = std::thread::scope(|scope| {
+        let handles = chunks
+            .map(|chunk| scope.spawn(move || encode_batch_length_delimited_to_vec(chunk)))
+            .collect::<Vec<_>>();
+        let mut encoded = vec![encode_batch_length_delimited_to_vec(first)];
+        encoded.extend(handles.into_iter().map(|handle| {
+            handle
+                .join()
+                .unwrap_or_else(|payload| std::panic::resume_unwind(payload))
+        }));
+        encoded
+    });
+
+    let required = encoded.iter().map(Vec::len).sum();
+    let remaining = buf.remaining_mut();
+    if required > remaining {
+        return Err(EncodeError::new(required, remaining));
+    }
+    for chunk in &encoded {
+        buf.put_slice(chunk);
+    }
+    Ok(())
+}
+
+/// Returns the encoded length of each message, and the encoded length of the whole batch,
+/// including the length-delimiters.
+fn sizes<'a, M>(messages: impl IntoIterator<Item = &'a M>) -> (Vec<usize>, usize)
+where
+    M: Message + 'a,
+{
+    let messages = messages.into_iter();
+    let mut lens = Vec::with_capacity(messages.size_hint().0);
+    let mut required = 0;
+    for message in messages {
+        let len = message.encoded_len();
+        lens.push(len);
+        required += len + encoded_len_varint(len as u64);
+    }
+    (lens, required)
+}
+
+/// Encodes the messages, whose encoded lengths are `lens`, each with a length-delimiter. The
+/// whole batch takes `required` bytes.
+fn encode_sized<'a, M>(
+    messages: impl Iterator<Item = &'a M>,
+    lens: &[usize],
+    required: usize,
+    buf: &mut impl BufMut,
+) -> Result<(), EncodeError>
+where
+    M: Message + 'a,
+{
+    let remaining = buf.remaining_mut();
+    if required > remaining {
+        return Err(EncodeError::new(required, remaining));
+    }
+
+    for (message, &len) in messages.zip(lens) {
+        encode_varint(len as u64, buf);
+        message.encode_raw(buf);
+    }
+    Ok(())
+}
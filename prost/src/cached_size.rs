@@ -0,0 +1,67 @@
+//! Support for caching the encoded length of a message.
+
+use core::fmt;
+use core::hash::{Hash, Hasher};
+use core::sync::atomic::{AtomicUsize, Ordering};
+
+/// A cache for the encoded length of a [`Message`](crate::Message).
+///
+/// Encoding a message writes a length prefix ahead of every nested message, which requires the
+/// nested message's encoded length. Without a cache, each level of nesting recomputes the encoded
+/// length of everything below it, so encoding a tree of depth `D` costs `O(D·N)` length
+/// computations. A message containing a field annotated with `#[prost(cached_size)]` instead
+/// stores its length whenever `encoded_len` is called, and the subsequent encoding pass reuses the
+/// stored lengths of nested messages.
+///
+/// The cached value is only meaningful between a call to `encoded_len` on the outermost message
+/// and the encoding pass which follows it. [`Message::encode`](crate::Message::encode) and the
+/// other encoding methods always size the message before writing it, so the cache does not need
+/// to be managed manually.
+///
+/// `CachedSize` does not take part in comparisons or hashing: two messages which differ only in
+/// their cached size are equal.
+#[derive(Default)]
+pub struct CachedSize(AtomicUsize);
+
+impl CachedSize {
+    /// Creates a new, empty `CachedSize`.
+    pub const fn new() -> CachedSize {
+        CachedSize(AtomicUsize::new(0))
+    }
+
+    /// Returns the most recently stored encoded length.
+    #[inline]
+    pub fn get(&self) -> usize {
+        self.0.load(Ordering::Relaxed)
+    }
+
+    /// Stores an encoded length.
+    #[inline]
+    pub fn set(&self, len: usize) {
+        self.0.store(len, Ordering::Relaxed)
+    }
+}
+
+impl Clone for CachedSize {
+    fn clone(&self) -> CachedSize {
+        CachedSize(AtomicUsize::new(self.get()))
+    }
+}
+
+impl fmt::Debug for CachedSize {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_tuple("CachedSize").field(&self.get()).finish()
+    }
+}
+
+impl PartialEq for CachedSize {
+    fn eq(&self, _: &CachedSize) -> bool {
+        true
+    }
+}
+
+impl Eq for CachedSize {}
+
+impl Hash for CachedSize {
+    fn hash<H: Hasher>(&self, _: &mut H) {}
+}
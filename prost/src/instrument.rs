@@ -0,0 +1,252 @@
+//! Instrumentation of encoding and decoding, for profiling by message type.
+//!
+//! With the `instrument` feature, the code generated by `prost-derive` reports what it does to a
+//! [`Sink`] installed with [`set_sink`]: how many bytes each message type decodes and encodes,
+//! how deeply nested it is decoded, how many allocations decoding it makes, and which fields it
+//! skips. This finds the message types worth optimizing, for example by storing their large
+//! fields as `bytes::Bytes`, or by decoding them lazily.
+//!
+//! Without the feature, the instrumentation compiles to nothing.
+//!
+//! # Examples
+//!
+//! ```rust
+//! # #[cfg(feature = "instrument")]
+//! # {
+//! use std::sync::atomic::{AtomicUsize, Ordering};
+//!
+//! use prost::instrument::{self, Sink};
+//!
+//! struct DecodedBytes(AtomicUsize);
+//!
+//! impl Sink for DecodedBytes {
+//!     fn decoded(&self, _message: &'static str, len: usize, _depth: u32, _allocations: u64) {
+//!         self.0.fetch_add(len, Ordering::Relaxed);
+//!     }
+//! }
+//!
+//! static SINK: DecodedBytes = DecodedBytes(AtomicUsize::new(0));
+//! assert!(instrument::set_sink(&SINK).is_ok());
+//! # }
+//! ```
+
+use core::fmt;
+#[cfg(feature = "instrument")]
+use std::sync::OnceLock;
+
+use bytes::{Buf, BufMut};
+
+use crate::encoding::{DecodeContext, WireType};
+use crate::{DecodeError, ReverseBuf};
+
+/// The installed sink.
+#[cfg(feature = "instrument")]
+static SINK: OnceLock<&'static dyn Sink> = OnceLock::new();
+
+/// A receiver of the events reported by instrumented messages.
+///
+/// Messages are identified by the name of their Rust type, as returned by
+/// [`core::any::type_name`]. The byte and allocation counts of a message include those of
+/// its nested messages, which are also reported on their own, before it. Every method does
+/// nothing by default.
+///
+/// The methods are called on the thread which is encoding or decoding, in the middle of it, so
+/// they should be cheap: typically they update counters, which are read elsewhere.
+#[cfg(feature = "instrument")]
+pub trait Sink: Send + Sync {
+    /// Called when a message has been decoded from `len` bytes, not counting its key and length
+    /// delimiter.
+    ///
+    /// `depth` is the number of messages it is nested in, which is decoded against the
+    /// recursion limit. It is always 0 with the `no-recursion-limit` feature. `allocations` is
+    /// the increase of [`allocation_count`](Sink::allocation_count) while decoding it.
+    fn decoded(&self, _message: &'static str, _len: usize, _depth: u32, _allocations: u64) {}
+
+    /// Called when a message has been encoded into `len` bytes, not counting its key and length
+    /// delimiter.
+    fn encoded(&self, _message: &'static str, _len: usize) {}
+
+    /// Called when a field of a message is skipped while decoding, because it is unknown and
+    /// not preserved, or because it is not selected by the [`Projection`](crate::Projection)
+    /// being decoded.
+    fn skipped_field(&self, _message: &'static str, _tag: u32, _wire_type: WireType) {}
+
+    /// Called when a field of a message with an unknown tag is decoded. Unless the message
+    /// preserves unknown fields, the field is then skipped.
+    fn unknown_field(&self, _message: &'static str, _tag: u32, _wire_type: WireType) {}
+
+    /// Returns the number of allocations made so far, by the current thread or the whole
+    /// process, typically counted by a global allocator.
+    ///
+    /// Returns 0 by default, in which case no allocations are reported.
+    fn allocation_count(&self) -> u64 {
+        0
+    }
+}
+
+/// Installs the sink receiving the events of instrumented messages, for the rest of the process.
+///
+/// A sink can be installed only once: if one is already installed, returns `sink` as an error.
+#[cfg(feature = "instrument")]
+pub fn set_sink(sink: &'static dyn Sink) -> Result<(), &'static dyn Sink> {
+    SINK.set(sink)
+}
+
+/// Returns the installed sink.
+#[cfg(feature = "instrument")]
+#[inline]
+fn sink() -> Option<&'static dyn Sink> {
+    SINK.get().copied()
+}
+
+/// The instrumentation of the decoding of a message.
+///
+/// Meant to be used only by `Message` implementations.
+#[doc(hidden)]
+pub struct Decode {
+    /// The sink, and the remaining length of the buffer, the depth and the allocation count
+    /// when decoding started.
+    #[cfg(feature = "instrument")]
+    start: Option<(&'static dyn Sink, usize, u32, u64)>,
+}
+
+impl Decode {
+    /// Starts instrumenting the decoding of a message from `buf`.
+    #[inline(always)]
+    #[allow(unused_variables)]
+    pub fn start(buf: &(impl Buf + ?Sized), ctx: &DecodeContext) -> Decode {
+        Decode {
+            #[cfg(feature = "instrument")]
+            start: sink().map(|sink| (sink, buf.remaining(), ctx.depth(), sink.allocation_count())),
+        }
+    }
+
+    /// Reports that a message of type `M` has been decoded.
+    #[inline(always)]
+    #[allow(unused_variables)]
+    pub fn finish<M: ?Sized>(self, buf: &(impl Buf + ?Sized)) {
+        #[cfg(feature = "instrument")]
+        if let Some((sink, remaining, depth, allocations)) = self.start {
+            sink.decoded(
+                core::any::type_name::<M>(),
+                remaining - buf.remaining(),
+                depth,
+                sink.allocation_count() - allocations,
+            );
+        }
+    }
+
+    /// Starts instrumenting the decoding of a top-level message of `len` bytes, which is decoded
+    /// in pieces by a [`StreamDecoder`](crate::StreamDecoder).
+    #[inline(always)]
+    #[allow(unused_variables)]
+    pub(crate) fn start_frame(len: usize) -> Decode {
+        Decode {
+            #[cfg(feature = "instrument")]
+            start: sink().map(|sink| (sink, len, 0, sink.allocation_count())),
+        }
+    }
+
+    /// Reports that a message of type `M`, started with `start_frame`, has been decoded.
+    #[inline(always)]
+    pub(crate) fn finish_frame<M: ?Sized>(self) {
+        #[cfg(feature = "instrument")]
+        if let Some((sink, len, depth, allocations)) = self.start {
+            sink.decoded(
+                core::any::type_name::<M>(),
+                len,
+                depth,
+                sink.allocation_count() - allocations,
+            );
+        }
+    }
+}
+
+impl fmt::Debug for Decode {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("Decode").finish_non_exhaustive()
+    }
+}
+
+/// The instrumentation of the encoding of a message.
+///
+/// Meant to be used only by `Message` implementations.
+#[doc(hidden)]
+pub struct Encode {
+    /// The sink, and the length written to the buffer when encoding started.
+    #[cfg(feature = "instrument")]
+    start: Option<(&'static dyn Sink, usize)>,
+}
+
+impl Encode {
+    /// Starts instrumenting the encoding of a message into `buf`.
+    #[inline(always)]
+    #[allow(unused_variables)]
+    pub fn start(buf: &(impl BufMut + ?Sized)) -> Encode {
+        Encode {
+            #[cfg(feature = "instrument")]
+            start: sink().map(|sink| (sink, buf.remaining_mut())),
+        }
+    }
+
+    /// Starts instrumenting the encoding of a message in front of the contents of `buf`.
+    #[inline(always)]
+    #[allow(unused_variables)]
+    pub fn start_reverse(buf: &ReverseBuf) -> Encode {
+        Encode {
+            #[cfg(feature = "instrument")]
+            start: sink().map(|sink| (sink, buf.len())),
+        }
+    }
+
+    /// Reports that a message of type `M` has been encoded into `buf`.
+    #[inline(always)]
+    #[allow(unused_variables)]
+    pub fn finish<M: ?Sized>(self, buf: &(impl BufMut + ?Sized)) {
+        #[cfg(feature = "instrument")]
+        if let Some((sink, remaining)) = self.start {
+            sink.encoded(core::any::type_name::<M>(), remaining - buf.remaining_mut());
+        }
+    }
+
+    /// Reports that a message of type `M` has been encoded in front of the contents of `buf`.
+    #[inline(always)]
+    #[allow(unused_variables)]
+    pub fn finish_reverse<M: ?Sized>(self, buf: &ReverseBuf) {
+        #[cfg(feature = "instrument")]
+        if let Some((sink, len)) = self.start {
+            sink.encoded(core::any::type_name::<M>(), buf.len() - len);
+        }
+    }
+}
+
+/// Skips a field of a message of type `M`, reporting it.
+///
+/// Meant to be used only by `Message` implementations.
+#[doc(hidden)]
+#[inline(always)]
+pub fn skip_field<M: ?Sized>(
+    wire_type: WireType,
+    tag: u32,
+    buf: &mut (impl Buf + ?Sized),
+    ctx: DecodeContext,
+) -> Result<(), DecodeError> {
+    #[cfg(feature = "instrument")]
+    if let Some(sink) = sink() {
+        sink.skipped_field(core::any::type_name::<M>(), tag, wire_type);
+    }
+    crate::encoding::skip_field(wire_type, tag, buf, ctx)
+}
+
+/// Reports a field of a message of type `M` with an unknown tag.
+///
+/// Meant to be used only by `Message` implementations.
+#[doc(hidden)]
+#[inline(always)]
+#[allow(unused_variables)]
+pub fn unknown_field<M: ?Sized>(tag: u32, wire_type: WireType) {
+    #[cfg(feature = "instrument")]
+    if let Some(sink) = sink() {
+        sink.unknown_field(core::any::type_name::<M>(), tag, wire_type);
+    }
+}
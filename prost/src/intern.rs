@@ -0,0 +1,358 @@
+//! Support for decoding repetitive strings into shared values.
+
+use core::borrow::Borrow;
+use core::cell::Cell;
+use core::cmp::Ordering;
+use core::fmt;
+use core::hash::{Hash, Hasher};
+use core::mem;
+use core::ops::Deref;
+use core::ptr::NonNull;
+use std::collections::HashSet;
+use std::sync::{Arc, OnceLock};
+
+use crate::encoding::StringAdapter;
+
+thread_local! {
+    /// The interner installed on this thread by `with_interner`.
+    static CURRENT: Cell<Option<NonNull<dyn Interner>>> = const { Cell::new(None) };
+}
+
+/// The empty string shared by every empty `Interned`, so that default and cleared fields do not
+/// allocate.
+static EMPTY: OnceLock<Arc<str>> = OnceLock::new();
+
+/// A source of shared strings, which returns the same string for equal values.
+///
+/// [`Interned`] string fields are decoded with the interner installed by [`with_interner`].
+pub trait Interner {
+    /// Returns a shared string equal to `value`.
+    fn intern(&mut self, value: &str) -> Arc<str>;
+}
+
+/// An interner which keeps one shared copy of every distinct string it has interned.
+///
+/// Interned strings stay in the interner after the messages using them are dropped, until
+/// [`remove_unused`](StringInterner::remove_unused) or [`clear`](StringInterner::clear) is
+/// called.
+#[derive(Debug, Default)]
+pub struct StringInterner {
+    strings: HashSet<Arc<str>>,
+}
+
+impl StringInterner {
+    /// Creates an empty interner.
+    pub fn new() -> StringInterner {
+        StringInterner::default()
+    }
+
+    /// Returns the number of distinct strings in the interner.
+    pub fn len(&self) -> usize {
+        self.strings.len()
+    }
+
+    /// Returns whether the interner is empty.
+    pub fn is_empty(&self) -> bool {
+        self.strings.is_empty()
+    }
+
+    /// Removes the strings which are not used outside of the interner.
+    pub fn remove_unused(&mut self) {
+        self.strings.retain(|string| Arc::strong_count(string) > 1);
+    }
+
+    /// Removes every string from the interner. The strings of decoded messages are not affected.
+    pub fn clear(&mut self) {
+        self.strings.clear();
+    }
+}
+
+impl Interner for StringInterner {
+    fn intern(&mut self, value: &str) -> Arc<str> {
+        if let Some(string) = self.strings.get(value) {
+            return string.clone();
+        }
+        let string = Arc::<str>::from(value);
+        self.strings.insert(string.clone());
+        string
+    }
+}
+
+/// Calls `f` with `interner` installed for the current thread, so that the [`Interned`] string
+/// fields decoded by `f` share the strings of `interner`.
+///
+/// The previously installed interner, if any, is installed again when `f` returns.
+///
+/// # Examples
+///
+/// ```rust
+/// # use prost::{Interned, Message, StringInterner};
+/// # #[derive(Message)]
+/// # struct Label {
+/// #     #[prost(string, tag = "1")]
+/// #     key: Interned,
+/// #     #[prost(string, tag = "2")]
+/// #     value: Interned,
+/// # }
+/// let label = Label { key: "host".into(), value: "example.com".into() };
+/// let encoded = label.encode_to_vec();
+///
+/// let mut interner = StringInterner::new();
+/// let (first, second) = prost::with_interner(&mut interner, || {
+///     (Label::decode(&*encoded).unwrap(), Label::decode(&*encoded).unwrap())
+/// });
+/// assert!(Interned::ptr_eq(&first.key, &second.key));
+/// assert_eq!(interner.len(), 2);
+/// ```
+pub fn with_interner<R>(interner: &mut dyn Interner, f: impl FnOnce() -> R) -> R {
+    /// Installs the previous interner again, even if `f` panics.
+    struct Restore(Option<NonNull<dyn Interner>>);
+
+    impl Drop for Restore {
+        fn drop(&mut self) {
+            CURRENT.with(|current| current.set(self.0));
+        }
+    }
+
+    // ## Unsafety
+    //
+    // The lifetime of the interner is erased to store it in the thread local. It is removed from
+    // the thread local before this function returns or unwinds, so it is never used after it is
+    // no longer borrowed.
+    let interner: NonNull<dyn Interner + '_> = NonNull::from(interner);
+    let interner: NonNull<dyn Interner> = unsafe { mem::transmute(interner) };
+    let _restore = Restore(CURRENT.with(|current| current.replace(Some(interner))));
+    f()
+}
+
+/// Returns whether an interner is installed for the current thread.
+pub(crate) fn installed() -> bool {
+    CURRENT.with(|current| current.get().is_some())
+}
+
+/// Returns a shared string equal to `value`, from the interner installed for the current thread.
+fn intern(value: &str) -> Arc<str> {
+    CURRENT.with(|current| {
+        // The interner is taken out of the thread local while it is used, so that it is never
+        // borrowed twice if it decodes messages itself.
+        let Some(mut interner) = current.take() else {
+            return Arc::from(value);
+        };
+
+        struct Restore<'a>(
+            &'a Cell<Option<NonNull<dyn Interner>>>,
+            NonNull<dyn Interner>,
+        );
+
+        impl Drop for Restore<'_> {
+            fn drop(&mut self) {
+                self.0.set(Some(self.1));
+            }
+        }
+
+        let _restore = Restore(current, interner);
+        // Safety: the interner is borrowed by `with_interner` while it is installed.
+        unsafe { interner.as_mut() }.intern(value)
+    })
+}
+
+/// A shared string, which can be used for `string` fields whose values repeat often.
+///
+/// Decoding an `Interned` field within [`with_interner`] reuses the string of the interner
+/// instead of allocating a new one, so that messages repeating the same values share a single
+/// copy of each. Without an installed interner, every value is allocated separately.
+///
+/// Cloning an `Interned` string only increments its reference count, and strings from the same
+/// interner are compared by pointer before their contents. Hashing and ordering use the contents
+/// of the string, like `str`, so that maps keyed by `Interned` can be looked up with a `&str`.
+#[derive(Clone)]
+pub struct Interned(Arc<str>);
+
+impl Interned {
+    /// Creates a string equal to `value`, from the interner installed for the current thread if
+    /// there is one.
+    pub fn new(value: &str) -> Interned {
+        if value.is_empty() {
+            return Interned::default();
+        }
+        Interned(intern(value))
+    }
+
+    /// Returns the contents of the string.
+    pub fn as_str(&self) -> &str {
+        &self.0
+    }
+
+    /// Returns whether both strings share the same allocation.
+    pub fn ptr_eq(this: &Interned, other: &Interned) -> bool {
+        Arc::ptr_eq(&this.0, &other.0)
+    }
+}
+
+impl StringAdapter for Interned {
+    fn as_str(&self) -> &str {
+        &self.0
+    }
+
+    fn replace_with(&mut self, value: &str) {
+        // A reused message is often decoded with the same value again.
+        if *self.0 != *value {
+            *self = Interned::new(value);
+        }
+    }
+}
+
+impl Default for Interned {
+    /// Returns the empty string, which is shared and does not allocate.
+    fn default() -> Interned {
+        Interned(EMPTY.get_or_init(|| Arc::from("")).clone())
+    }
+}
+
+impl Deref for Interned {
+    type Target = str;
+
+    fn deref(&self) -> &str {
+        &self.0
+    }
+}
+
+impl AsRef<str> for Interned {
+    fn as_ref(&self) -> &str {
+        &self.0
+    }
+}
+
+impl Borrow<str> for Interned {
+    fn borrow(&self) -> &str {
+        &self.0
+    }
+}
+
+impl PartialEq for Interned {
+    fn eq(&self, other: &Interned) -> bool {
+        Interned::ptr_eq(self, other) || self.0 == other.0
+    }
+}
+
+impl Eq for Interned {}
+
+impl PartialEq<str> for Interned {
+    fn eq(&self, other: &str) -> bool {
+        *self.0 == *other
+    }
+}
+
+impl PartialEq<&str> for Interned {
+    fn eq(&self, other: &&str) -> bool {
+        *self.0 == **other
+    }
+}
+
+impl Hash for Interned {
+    fn hash<H: Hasher>(&self, state: &mut H) {
+        self.0.hash(state)
+    }
+}
+
+impl PartialOrd for Interned {
+    fn partial_cmp(&self, other: &Interned) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl Ord for Interned {
+    fn cmp(&self, other: &Interned) -> Ordering {
+        self.0.cmp(&other.0)
+    }
+}
+
+impl fmt::Debug for Interned {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        fmt::Debug::fmt(&*self.0, f)
+    }
+}
+
+impl fmt::Display for Interned {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        fmt::Display::fmt(&*self.0, f)
+    }
+}
+
+impl From<&str> for Interned {
+    fn from(value: &str) -> Interned {
+        Interned::new(value)
+    }
+}
+
+impl From<String> for Interned {
+    fn from(value: String) -> Interned {
+        Interned::new(&value)
+    }
+}
+
+impl From<Arc<str>> for Interned {
+    /// Wraps a shared string, without interning it.
+    fn from(value: Arc<str>) -> Interned {
+        Interned(value)
+    }
+}
+
+impl From<Interned> for Arc<str> {
+    fn from(value: Interned) -> Arc<str> {
+        value.0
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn check_interner() {
+        let mut interner = StringInterner::new();
+        let (a, b, c) = with_interner(&mut interner, || {
+            (Interned::new("a"), Interned::new("a"), Interned::new("b"))
+        });
+        assert!(Interned::ptr_eq(&a, &b));
+        assert_eq!(a, b);
+        assert_ne!(a, c);
+        assert_eq!(interner.len(), 2);
+
+        // Without an interner, equal strings are allocated separately.
+        let d = Interned::new("a");
+        assert!(!Interned::ptr_eq(&a, &d));
+        assert_eq!(a, d);
+
+        drop(c);
+        interner.remove_unused();
+        assert_eq!(interner.len(), 1);
+    }
+
+    #[test]
+    fn check_empty() {
+        let mut interner = StringInterner::new();
+        let empty = with_interner(&mut interner, || Interned::new(""));
+        assert!(Interned::ptr_eq(&empty, &Interned::default()));
+        assert!(interner.is_empty());
+
+        let mut cleared = Interned::new("a");
+        StringAdapter::clear(&mut cleared);
+        assert!(Interned::ptr_eq(&cleared, &Interned::default()));
+    }
+
+    #[test]
+    fn check_nested_interners() {
+        let mut outer = StringInterner::new();
+        let mut inner = StringInterner::new();
+        with_interner(&mut outer, || {
+            let a = Interned::new("a");
+            with_interner(&mut inner, || Interned::new("b"));
+            let c = Interned::new("c");
+            assert!(!Interned::ptr_eq(&a, &c));
+        });
+        assert_eq!(outer.len(), 2);
+        assert_eq!(inner.len(), 1);
+        assert!(CURRENT.with(Cell::get).is_none());
+    }
+}
@@ -0,0 +1,280 @@
+//! Support for lazily decoded message fields.
+
+use core::fmt;
+
+use bytes::{Buf, BufMut, Bytes, BytesMut};
+
+use crate::encoding::{decode_key, DecodeContext, EncodeBuf};
+use crate::{DecodeError, Message};
+
+/// A message field which is decoded on first access.
+///
+/// When a message containing a `Lazy` field is decoded, the field keeps the encoded bytes of the
+/// nested message instead of decoding them. The nested message is only decoded when it is
+/// accessed through [`get`](Lazy::get), [`get_mut`](Lazy::get_mut), [`decode`](Lazy::decode) or
+/// [`into_inner`](Lazy::into_inner). A field which is never modified is encoded again by copying
+/// the original bytes verbatim, so forwarding a message does not pay for decoding and re-encoding
+/// sub-messages which are never read.
+///
+/// The encoded bytes are split off the input buffer with [`Buf::copy_to_bytes`], which is
+/// zero-copy when decoding from [`Bytes`].
+///
+/// The encoded bytes are not validated until the nested message is decoded, so a malformed nested
+/// message is reported when it is first accessed, not when the outer message is decoded. The
+/// recursion limit also restarts at the lazy field.
+#[derive(Clone, Default)]
+pub struct Lazy<M> {
+    /// The encoded nested message, until the decoded message may have been modified.
+    encoded: Bytes,
+    /// The nested message, once it has been decoded.
+    message: Decoded<M>,
+}
+
+impl<M> Lazy<M>
+where
+    M: Message + Default,
+{
+    /// Creates a new `Lazy` holding an already decoded message.
+    pub fn new(message: M) -> Lazy<M> {
+        Lazy {
+            encoded: Bytes::new(),
+            message: Decoded::new(message),
+        }
+    }
+
+    /// Creates a new `Lazy` from the encoded bytes of a message, without a length delimiter.
+    pub fn from_encoded(encoded: Bytes) -> Lazy<M> {
+        Lazy {
+            encoded,
+            message: Decoded::default(),
+        }
+    }
+
+    /// Returns `true` if the nested message has been decoded.
+    pub fn is_decoded(&self) -> bool {
+        self.message.get().is_some()
+    }
+
+    /// Returns the encoded bytes of the nested message, if it has not been accessed mutably.
+    pub fn encoded(&self) -> Option<&Bytes> {
+        match self.modified() {
+            Some(_) => None,
+            None => Some(&self.encoded),
+        }
+    }
+
+    /// Decodes the nested message, and returns a reference to it.
+    ///
+    /// The decoded message is stored, so the message is decoded at most once. The encoded bytes
+    /// are kept as well, and the field is still encoded by copying them until it is accessed
+    /// through [`get_mut`](Lazy::get_mut).
+    ///
+    /// This requires the `std` feature, to store the message safely through a shared reference.
+    #[cfg(feature = "std")]
+    pub fn get(&self) -> Result<&M, DecodeError> {
+        if let Some(message) = self.message.get() {
+            return Ok(message);
+        }
+        let message = M::decode(self.encoded.clone())?;
+        Ok(self.message.get_or_init(message))
+    }
+
+    /// Decodes the nested message, and returns a mutable reference to it.
+    ///
+    /// The decoded message replaces the encoded bytes, so the message is decoded at most once,
+    /// and is encoded from its decoded form afterwards.
+    pub fn get_mut(&mut self) -> Result<&mut M, DecodeError> {
+        if self.message.get().is_none() {
+            self.message = Decoded::new(M::decode(self.encoded.clone())?);
+        }
+        self.encoded = Bytes::new();
+        Ok(self.message.get_mut().unwrap())
+    }
+
+    /// Returns a copy of the nested message, decoding it if necessary.
+    ///
+    /// Unlike [`get`](Lazy::get) and [`get_mut`](Lazy::get_mut), this does not store the decoded
+    /// message.
+    pub fn decode(&self) -> Result<M, DecodeError>
+    where
+        M: Clone,
+    {
+        match self.message.get() {
+            Some(message) => Ok(message.clone()),
+            None => M::decode(self.encoded.clone()),
+        }
+    }
+
+    /// Returns the nested message, decoding it if necessary.
+    pub fn into_inner(self) -> Result<M, DecodeError> {
+        match self.message.into_inner() {
+            Some(message) => Ok(message),
+            None => M::decode(self.encoded),
+        }
+    }
+
+    /// Clears the nested message, resetting it to its default.
+    pub fn clear(&mut self) {
+        self.encoded = Bytes::new();
+        self.message = Decoded::default();
+    }
+
+    /// Returns the decoded message if the field is encoded from it, or `None` if the encoded bytes
+    /// are copied verbatim.
+    fn modified(&self) -> Option<&M> {
+        self.message.get().filter(|_| self.encoded.is_empty())
+    }
+
+    /// Returns the encoded length of the nested message, without a length delimiter.
+    pub(crate) fn encoded_len(&self) -> usize {
+        match self.modified() {
+            Some(message) => message.encoded_len(),
+            None => self.encoded.len(),
+        }
+    }
+
+    /// Returns the encoded length of the nested message, as computed by the most recent call to
+    /// `encoded_len`.
+    pub(crate) fn cached_encoded_len(&self) -> usize {
+        match self.modified() {
+            Some(message) => message.cached_encoded_len(),
+            None => self.encoded.len(),
+        }
+    }
+
+    /// Encodes the nested message to a buffer, without a length delimiter.
+    pub(crate) fn encode_raw(&self, buf: &mut (impl EncodeBuf + ?Sized)) {
+        match self.modified() {
+            Some(message) => buf.encode_raw(message),
+            None => buf.put_slice(&self.encoded),
+        }
+    }
+
+    /// Merges an encoded message, without a length delimiter, into the nested message.
+    ///
+    /// A message which has not been decoded stays encoded: merging encoded messages is the same
+    /// as concatenating them.
+    pub(crate) fn merge_encoded(
+        &mut self,
+        mut encoded: Bytes,
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError> {
+        match self.message.get_mut() {
+            Some(message) => {
+                // The decoded message is modified, so the encoded bytes no longer match it.
+                self.encoded = Bytes::new();
+                let ctx = ctx.with_limit(0);
+                while encoded.has_remaining() {
+                    let (tag, wire_type) = decode_key(&mut encoded)?;
+                    message.merge_field(tag, wire_type, &mut encoded, ctx.clone())?;
+                }
+            }
+            None if self.encoded.is_empty() => self.encoded = encoded,
+            None => {
+                let mut concatenated = BytesMut::with_capacity(self.encoded.len() + encoded.len());
+                concatenated.put_slice(&self.encoded);
+                concatenated.put_slice(&encoded);
+                self.encoded = concatenated.freeze();
+            }
+        }
+        Ok(())
+    }
+}
+
+impl<M> From<M> for Lazy<M>
+where
+    M: Message + Default,
+{
+    fn from(message: M) -> Lazy<M> {
+        Lazy::new(message)
+    }
+}
+
+impl<M> fmt::Debug for Lazy<M>
+where
+    M: fmt::Debug,
+{
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self.message.get() {
+            Some(message) => message.fmt(f),
+            None => f
+                .debug_struct("Lazy")
+                .field("encoded_len", &self.encoded.len())
+                .finish(),
+        }
+    }
+}
+
+/// Compares the nested messages. A message which has not been decoded is decoded for the
+/// comparison; if it fails to decode, it is only equal to identical encoded bytes.
+impl<M> PartialEq for Lazy<M>
+where
+    M: Message + Default + PartialEq,
+{
+    fn eq(&self, other: &Lazy<M>) -> bool {
+        match (self.message.get(), other.message.get()) {
+            (Some(a), Some(b)) => a == b,
+            (None, None) if self.encoded == other.encoded => true,
+            (Some(message), None) | (None, Some(message)) => {
+                let encoded = if self.message.get().is_none() {
+                    &self.encoded
+                } else {
+                    &other.encoded
+                };
+                M::decode(encoded.clone()).map_or(false, |decoded| decoded == *message)
+            }
+            (None, None) => match (
+                M::decode(self.encoded.clone()),
+                M::decode(other.encoded.clone()),
+            ) {
+                (Ok(a), Ok(b)) => a == b,
+                _ => false,
+            },
+        }
+    }
+}
+
+/// The decoded message of a [`Lazy`] field. With `std`, it can be stored through a shared
+/// reference, by [`Lazy::get`].
+#[derive(Clone, Default)]
+struct Decoded<M> {
+    #[cfg(feature = "std")]
+    cell: std::sync::OnceLock<M>,
+    #[cfg(not(feature = "std"))]
+    cell: Option<M>,
+}
+
+impl<M> Decoded<M> {
+    fn new(message: M) -> Decoded<M> {
+        Decoded {
+            cell: message.into(),
+        }
+    }
+
+    fn get(&self) -> Option<&M> {
+        #[cfg(feature = "std")]
+        return self.cell.get();
+        #[cfg(not(feature = "std"))]
+        return self.cell.as_ref();
+    }
+
+    fn get_mut(&mut self) -> Option<&mut M> {
+        #[cfg(feature = "std")]
+        return self.cell.get_mut();
+        #[cfg(not(feature = "std"))]
+        return self.cell.as_mut();
+    }
+
+    /// Stores the message unless another thread stored one first, and returns the stored message.
+    #[cfg(feature = "std")]
+    fn get_or_init(&self, message: M) -> &M {
+        self.cell.get_or_init(|| message)
+    }
+
+    fn into_inner(self) -> Option<M> {
+        #[cfg(feature = "std")]
+        return self.cell.into_inner();
+        #[cfg(not(feature = "std"))]
+        return self.cell;
+    }
+}
@@ -9,17 +9,54 @@ pub extern crate alloc;
 // Re-export the bytes crate for use within derived code.
 pub use bytes;
 
+mod batch;
+mod cached_size;
 mod error;
+#[cfg(feature = "std")]
+mod intern;
+mod lazy;
 mod message;
 mod name;
+mod options;
+#[cfg(feature = "std")]
+mod parallel;
+#[cfg(feature = "std")]
+mod projection;
+mod reverse;
+mod stream;
 mod types;
+mod unknown;
+mod vectored;
+mod view;
 
 #[doc(hidden)]
 pub mod encoding;
+#[cfg_attr(not(feature = "instrument"), doc(hidden))]
+pub mod instrument;
 
+#[cfg(feature = "std")]
+pub use crate::batch::encode_batch_length_delimited_parallel;
+pub use crate::batch::{
+    encode_batch_length_delimited, encode_batch_length_delimited_iter,
+    encode_batch_length_delimited_to_vec,
+};
+pub use crate::cached_size::CachedSize;
 pub use crate::error::{DecodeError, EncodeError, UnknownEnumValue};
+#[cfg(feature = "std")]
+pub use crate::intern::{with_interner, Interned, Interner, StringInterner};
+pub use crate::lazy::Lazy;
 pub use crate::message::Message;
 pub use crate::name::Name;
+pub use crate::options::DecodeOptions;
+#[cfg(feature = "std")]
+pub use crate::parallel::merge_repeated_parallel;
+#[cfg(feature = "std")]
+pub use crate::projection::Projection;
+pub use crate::reverse::ReverseBuf;
+pub use crate::stream::StreamDecoder;
+pub use crate::unknown::UnknownFields;
+pub use crate::vectored::VectoredBuf;
+pub use crate::view::MessageView;
 
 use bytes::{Buf, BufMut};
 
@@ -8,10 +8,15 @@ use core::fmt::Debug;
 use bytes::{Buf, BufMut};
 
 use crate::encoding::{
-    decode_key, encode_varint, encoded_len_varint, message, DecodeContext, WireType,
+    decode_key, encode_varint, encoded_len_varint, message, DecodeContext, DynBufMut, WireType,
 };
+use crate::instrument;
 use crate::DecodeError;
+use crate::DecodeOptions;
 use crate::EncodeError;
+#[cfg(feature = "std")]
+use crate::Projection;
+use crate::ReverseBuf;
 
 /// A Protocol Buffers message.
 pub trait Message: Debug + Send + Sync {
@@ -25,6 +30,18 @@ pub trait Message: Debug + Send + Sync {
     where
         Self: Sized;
 
+    /// Encodes the message in front of the contents of a reverse buffer, writing its fields from
+    /// last to first.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    fn encode_raw_reverse(&self, buf: &mut ReverseBuf)
+    where
+        Self: Sized,
+    {
+        buf.prepend_with(self.encoded_len(), |buf| self.encode_raw(buf));
+    }
+
     /// Decodes a field from a buffer, and merges it into `self`.
     ///
     /// Meant to be used only by `Message` implementations.
@@ -39,9 +56,140 @@ pub trait Message: Debug + Send + Sync {
     where
         Self: Sized;
 
+    /// Decodes fields from a buffer until `limit` bytes remain, and merges them into `self`.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    fn merge_fields(
+        &mut self,
+        buf: &mut impl Buf,
+        limit: usize,
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError>
+    where
+        Self: Sized,
+    {
+        let instrument = instrument::Decode::start(buf, &ctx);
+        while buf.remaining() > limit {
+            let (tag, wire_type) = decode_key(buf)?;
+            self.merge_field(tag, wire_type, buf, ctx.clone())?;
+        }
+        instrument.finish::<Self>(buf);
+        Ok(())
+    }
+
+    /// Replaces the contents of `self` with fields decoded from a buffer until `limit` bytes
+    /// remain, reusing the allocations of nested messages where possible.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    fn replace_fields(
+        &mut self,
+        buf: &mut impl Buf,
+        limit: usize,
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError>
+    where
+        Self: Sized,
+    {
+        self.clear();
+        self.merge_fields(buf, limit, ctx)
+    }
+
+    /// Encodes the message to a trait object buffer, like `encode_raw`.
+    ///
+    /// Messages derived with `#[prost(dyn_buf)]` implement `encode_raw` by calling this method,
+    /// so that their encoding code is compiled once rather than for every buffer type.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    fn encode_raw_dyn(&self, mut buf: &mut dyn DynBufMut)
+    where
+        Self: Sized,
+    {
+        self.encode_raw(&mut buf)
+    }
+
+    /// Decodes a field from a trait object buffer, like `merge_field`.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    fn merge_field_dyn(
+        &mut self,
+        tag: u32,
+        wire_type: WireType,
+        mut buf: &mut dyn Buf,
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError>
+    where
+        Self: Sized,
+    {
+        self.merge_field(tag, wire_type, &mut buf, ctx)
+    }
+
+    /// Decodes fields from a trait object buffer, like `merge_fields`.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    fn merge_fields_dyn(
+        &mut self,
+        mut buf: &mut dyn Buf,
+        limit: usize,
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError>
+    where
+        Self: Sized,
+    {
+        self.merge_fields(&mut buf, limit, ctx)
+    }
+
+    /// Replaces the contents of `self` with fields decoded from a trait object buffer, like
+    /// `replace_fields`.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    fn replace_fields_dyn(
+        &mut self,
+        mut buf: &mut dyn Buf,
+        limit: usize,
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError>
+    where
+        Self: Sized,
+    {
+        self.replace_fields(&mut buf, limit, ctx)
+    }
+
+    /// Appends the tags of the fields named by a dot-separated path of field names to `tags`,
+    /// and returns `false` if the path does not name a field of the message.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    fn resolve_field_path(path: &str, tags: &mut Vec<u32>) -> bool
+    where
+        Self: Sized,
+    {
+        let _ = (path, tags);
+        false
+    }
+
     /// Returns the encoded length of the message without a length delimiter.
     fn encoded_len(&self) -> usize;
 
+    /// Returns the encoded length of the message without a length delimiter, as computed by the
+    /// most recent call to `encoded_len`.
+    ///
+    /// Messages with a [`CachedSize`](crate::CachedSize) field return the stored length, which
+    /// lets an encoding pass write length prefixes of nested messages without sizing them again.
+    /// All other messages recompute the length.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    #[inline]
+    fn cached_encoded_len(&self) -> usize {
+        self.encoded_len()
+    }
+
     /// Encodes the message to a buffer.
     ///
     /// An error will be returned if the buffer does not have sufficient capacity.
@@ -59,6 +207,18 @@ pub trait Message: Debug + Send + Sync {
         Ok(())
     }
 
+    /// Encodes the message in a single pass, in front of the contents of a reverse buffer.
+    ///
+    /// The result is the same as with [`encode`](Message::encode), but the message is written
+    /// back to front, which makes the separate computation of its encoded length unnecessary.
+    /// This is faster for messages with nested messages. See [`ReverseBuf`] for details.
+    fn encode_reverse(&self, buf: &mut ReverseBuf)
+    where
+        Self: Sized,
+    {
+        self.encode_raw_reverse(buf)
+    }
+
     /// Encodes the message to a newly allocated buffer.
     fn encode_to_vec(&self) -> Vec<u8>
     where
@@ -70,6 +230,29 @@ pub trait Message: Debug + Send + Sync {
         buf
     }
 
+    /// Encodes the message to a buffer, with the same bytes every time.
+    ///
+    /// Fields are always encoded in tag order, but the entries of a `HashMap` field are normally
+    /// encoded in the map's iteration order, which differs between maps with the same contents.
+    /// This method encodes them in key order instead, so that equal messages encode to equal
+    /// bytes, as required to hash or compare encoded messages. `BTreeMap` fields are always
+    /// encoded in key order.
+    ///
+    /// The entries of each map are sorted while it is encoded, which makes encoding maps slower.
+    /// Unknown fields preserved by [`UnknownFields`](crate::UnknownFields) are encoded as they
+    /// were decoded.
+    ///
+    /// An error will be returned if the buffer does not have sufficient capacity.
+    fn encode_deterministic(&self, buf: &mut impl BufMut) -> Result<(), EncodeError>
+    where
+        Self: Sized,
+    {
+        #[cfg(feature = "std")]
+        return crate::encoding::hash_map::deterministic(|| self.encode(buf));
+        #[cfg(not(feature = "std"))]
+        self.encode(buf)
+    }
+
     /// Encodes the message with a length-delimiter to a buffer.
     ///
     /// An error will be returned if the buffer does not have sufficient capacity.
@@ -112,6 +295,24 @@ pub trait Message: Debug + Send + Sync {
         Self::merge(&mut message, &mut buf).map(|_| message)
     }
 
+    /// Decodes an instance of the message from a buffer, within the limits of the given
+    /// options.
+    ///
+    /// Returns an error as soon as a limit is exceeded. See [`DecodeOptions`] for the limits
+    /// which can be set.
+    ///
+    /// The entire buffer will be consumed.
+    fn decode_with_options(mut buf: impl Buf, options: &DecodeOptions) -> Result<Self, DecodeError>
+    where
+        Self: Default,
+    {
+        let mut message = Self::default();
+        crate::options::decode_with_options(options, buf.remaining(), |ctx| {
+            message.merge_fields(&mut buf, 0, ctx)
+        })?;
+        Ok(message)
+    }
+
     /// Decodes a length-delimited instance of the message from the buffer.
     fn decode_length_delimited(buf: impl Buf) -> Result<Self, DecodeError>
     where
@@ -129,12 +330,55 @@ pub trait Message: Debug + Send + Sync {
     where
         Self: Sized,
     {
-        let ctx = DecodeContext::default();
-        while buf.has_remaining() {
-            let (tag, wire_type) = decode_key(&mut buf)?;
-            self.merge_field(tag, wire_type, &mut buf, ctx.clone())?;
-        }
-        Ok(())
+        self.merge_fields(&mut buf, 0, DecodeContext::default())
+    }
+
+    /// Decodes an instance of the message from a buffer into `self`, replacing its contents.
+    ///
+    /// The result is the same as calling [`clear`](Message::clear) followed by
+    /// [`merge`](Message::merge), but the storage of repeated and optional message fields is
+    /// reused: decoded nested messages overwrite the existing ones, keeping the capacity of their
+    /// strings and repeated fields, instead of being allocated again. This saves allocations when
+    /// decoding many messages of the same type into a single instance.
+    ///
+    /// The entire buffer will be consumed.
+    fn decode_reusing(&mut self, mut buf: impl Buf) -> Result<(), DecodeError>
+    where
+        Self: Sized,
+    {
+        self.replace_fields(&mut buf, 0, DecodeContext::default())
+    }
+
+    /// Decodes the fields selected by a projection from a buffer, leaving all other fields at
+    /// their default value.
+    ///
+    /// Fields which are not selected are skipped without being decoded. See
+    /// [`Projection`](crate::Projection) for how fields are selected.
+    ///
+    /// The entire buffer will be consumed.
+    #[cfg(feature = "std")]
+    fn decode_projected(mut buf: impl Buf, projection: &Projection) -> Result<Self, DecodeError>
+    where
+        Self: Default,
+    {
+        let mut message = Self::default();
+        message.merge_projected(&mut buf, projection)?;
+        Ok(message)
+    }
+
+    /// Decodes the fields selected by a projection from a buffer, and merges them into `self`.
+    ///
+    /// The entire buffer will be consumed.
+    #[cfg(feature = "std")]
+    fn merge_projected(
+        &mut self,
+        mut buf: impl Buf,
+        projection: &Projection,
+    ) -> Result<(), DecodeError>
+    where
+        Self: Sized,
+    {
+        crate::projection::decode_projected(projection, |ctx| self.merge_fields(&mut buf, 0, ctx))
     }
 
     /// Decodes a length-delimited instance of the message from buffer, and
@@ -162,6 +406,9 @@ where
     fn encode_raw(&self, buf: &mut impl BufMut) {
         (**self).encode_raw(buf)
     }
+    fn encode_raw_reverse(&self, buf: &mut ReverseBuf) {
+        (**self).encode_raw_reverse(buf)
+    }
     fn merge_field(
         &mut self,
         tag: u32,
@@ -171,9 +418,59 @@ where
     ) -> Result<(), DecodeError> {
         (**self).merge_field(tag, wire_type, buf, ctx)
     }
+    fn merge_fields(
+        &mut self,
+        buf: &mut impl Buf,
+        limit: usize,
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError> {
+        (**self).merge_fields(buf, limit, ctx)
+    }
+    fn replace_fields(
+        &mut self,
+        buf: &mut impl Buf,
+        limit: usize,
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError> {
+        (**self).replace_fields(buf, limit, ctx)
+    }
+    fn encode_raw_dyn(&self, buf: &mut dyn DynBufMut) {
+        (**self).encode_raw_dyn(buf)
+    }
+    fn merge_field_dyn(
+        &mut self,
+        tag: u32,
+        wire_type: WireType,
+        buf: &mut dyn Buf,
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError> {
+        (**self).merge_field_dyn(tag, wire_type, buf, ctx)
+    }
+    fn merge_fields_dyn(
+        &mut self,
+        buf: &mut dyn Buf,
+        limit: usize,
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError> {
+        (**self).merge_fields_dyn(buf, limit, ctx)
+    }
+    fn replace_fields_dyn(
+        &mut self,
+        buf: &mut dyn Buf,
+        limit: usize,
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError> {
+        (**self).replace_fields_dyn(buf, limit, ctx)
+    }
+    fn resolve_field_path(path: &str, tags: &mut Vec<u32>) -> bool {
+        M::resolve_field_path(path, tags)
+    }
     fn encoded_len(&self) -> usize {
         (**self).encoded_len()
     }
+    fn cached_encoded_len(&self) -> usize {
+        (**self).cached_encoded_len()
+    }
     fn clear(&mut self) {
         (**self).clear()
     }
@@ -24,11 +24,22 @@ pub trait Name: Message {
         format!("{}.{}", Self::PACKAGE, Self::NAME)
     }
 
+    /// Type URL for this [`Message`], if it is known at compile time.
+    ///
+    /// This is the same as [`type_url`](Name::type_url), which returns it when set. It lets the
+    /// type URL be compared and stored without allocating, for example when packing into and
+    /// unpacking from the `google.protobuf.Any` type. The implementations generated by
+    /// `prost-build` set it. By default, it is not set.
+    const TYPE_URL: Option<&'static str> = None;
+
     /// Type URL for this [`Message`], which by default is the full name with a
     /// leading slash, but may also include a leading domain name, e.g.
     /// `type.googleapis.com/google.profile.Person`.
     /// This can be used when serializing into the `google.protobuf.Any` type.
     fn type_url() -> String {
-        format!("/{}", Self::full_name())
+        match Self::TYPE_URL {
+            Some(type_url) => type_url.into(),
+            None => format!("/{}", Self::full_name()),
+        }
     }
 }
@@ -0,0 +1,218 @@
+//! Support for decoding with limits on the resources used by decoding.
+
+#[cfg(feature = "std")]
+use std::cell::Cell;
+
+use crate::encoding::DecodeContext;
+#[cfg(feature = "std")]
+use crate::DecodeError;
+
+#[cfg(feature = "std")]
+thread_local! {
+    /// The limits of the options being decoded with on this thread.
+    static CURRENT: Cell<Limits> = const { Cell::new(Limits::UNLIMITED) };
+}
+
+/// Limits on the resources used to decode a message, for decoding untrusted input.
+///
+/// Decoding a message with [`Message::decode_with_options`](crate::Message::decode_with_options)
+/// fails as soon as one of the limits is exceeded, before the memory exceeding it is allocated.
+/// The limits apply to everything decoded on the current thread until it returns.
+/// Without a limit, the memory used by a decoded message is bounded only by the size of its
+/// encoding: a packed repeated `uint64` field uses up to eight times its encoded size, and a
+/// repeated message field uses the size of the message type for each element, even if it is
+/// encoded in two bytes.
+///
+/// Every limit is unbounded by default, except for the recursion limit, which is the same as
+/// that of [`Message::decode`](crate::Message::decode).
+///
+/// # Examples
+///
+/// ```rust
+/// # use prost::{DecodeOptions, Message};
+/// # #[derive(Message)]
+/// # struct Batch {
+/// #     #[prost(uint64, repeated, tag = "1")]
+/// #     ids: Vec<u64>,
+/// # }
+/// let batch = Batch { ids: (0..1000).collect() };
+/// let encoded = batch.encode_to_vec();
+///
+/// let options = DecodeOptions::new().max_message_size(1024 * 1024);
+/// assert!(Batch::decode_with_options(&*encoded, &options).is_ok());
+///
+/// let options = DecodeOptions::new().max_message_size(1024);
+/// assert!(Batch::decode_with_options(&*encoded, &options).is_err());
+/// ```
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct DecodeOptions {
+    recursion_limit: u32,
+    max_message_size: usize,
+    #[cfg(feature = "std")]
+    limits: Limits,
+}
+
+/// The limits of a decode which are checked against the state of the current thread.
+#[cfg(feature = "std")]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+struct Limits {
+    /// The number of bytes which can still be allocated.
+    allocation: usize,
+    /// The maximum number of elements of a repeated field.
+    repeated_len: usize,
+}
+
+#[cfg(feature = "std")]
+impl Limits {
+    const UNLIMITED: Limits = Limits {
+        allocation: usize::MAX,
+        repeated_len: usize::MAX,
+    };
+}
+
+impl DecodeOptions {
+    /// Creates options with the default limits.
+    pub const fn new() -> DecodeOptions {
+        DecodeOptions {
+            #[cfg(not(feature = "no-recursion-limit"))]
+            recursion_limit: crate::RECURSION_LIMIT,
+            #[cfg(feature = "no-recursion-limit")]
+            recursion_limit: u32::MAX,
+            max_message_size: usize::MAX,
+            #[cfg(feature = "std")]
+            limits: Limits::UNLIMITED,
+        }
+    }
+
+    /// Sets the number of messages which can be nested in one another, 100 by default.
+    ///
+    /// Groups and map entries count as nested messages. The recursion limit is ignored when
+    /// the crate is built with the `no-recursion-limit` feature.
+    pub const fn recursion_limit(mut self, limit: u32) -> DecodeOptions {
+        self.recursion_limit = limit;
+        self
+    }
+
+    /// Sets the maximum size of the encoded message, in bytes.
+    ///
+    /// The size is checked before anything is decoded.
+    pub const fn max_message_size(mut self, size: usize) -> DecodeOptions {
+        self.max_message_size = size;
+        self
+    }
+
+    /// Sets the maximum number of bytes allocated by the decoded message.
+    ///
+    /// This counts the length of every string and bytes field and of every preserved unknown
+    /// field, and the size of every element of repeated fields and maps, which is their
+    /// in-memory size rather than their encoded size. The capacity reserved ahead of time for a
+    /// run of repeated messages or map entries is counted when it is reserved, and clamped to the
+    /// limits. Bytes fields and unknown fields decoded without copying from a `Bytes` buffer are
+    /// counted too.
+    #[cfg(feature = "std")]
+    pub const fn max_allocation(mut self, size: usize) -> DecodeOptions {
+        self.limits.allocation = size;
+        self
+    }
+
+    /// Sets the maximum number of elements of any one repeated field or map.
+    #[cfg(feature = "std")]
+    pub const fn max_repeated_len(mut self, len: usize) -> DecodeOptions {
+        self.limits.repeated_len = len;
+        self
+    }
+}
+
+impl Default for DecodeOptions {
+    fn default() -> DecodeOptions {
+        DecodeOptions::new()
+    }
+}
+
+/// Decodes `len` bytes with the given options: returns an error if the message is too large, and
+/// otherwise calls `decode` with a context enforcing the options, while their limits are
+/// installed for the current thread.
+pub(crate) fn decode_with_options<R>(
+    options: &DecodeOptions,
+    len: usize,
+    decode: impl FnOnce(DecodeContext) -> Result<R, crate::DecodeError>,
+) -> Result<R, crate::DecodeError> {
+    if len > options.max_message_size {
+        return Err(crate::DecodeError::new("message size limit exceeded"));
+    }
+
+    #[cfg(feature = "std")]
+    {
+        /// Restores the previously installed limits, even if decoding panics.
+        struct Restore(Limits);
+
+        impl Drop for Restore {
+            fn drop(&mut self) {
+                CURRENT.with(|current| current.set(self.0));
+            }
+        }
+
+        let _restore = Restore(CURRENT.with(|current| current.replace(options.limits)));
+        decode(DecodeContext::with_recursion_limit(options.recursion_limit))
+    }
+
+    #[cfg(not(feature = "std"))]
+    decode(DecodeContext::with_recursion_limit(options.recursion_limit))
+}
+
+/// Returns whether limits are installed for the current thread.
+#[cfg(feature = "std")]
+#[inline]
+pub(crate) fn limited() -> bool {
+    CURRENT.with(Cell::get) != Limits::UNLIMITED
+}
+
+/// Checks that `additional` elements of `element_size` bytes can be added to a repeated field
+/// of `len` elements, and charges them to the installed allocation limit.
+#[cfg(feature = "std")]
+#[inline]
+pub(crate) fn check_repeated(
+    len: usize,
+    additional: usize,
+    element_size: usize,
+) -> Result<(), DecodeError> {
+    let limits = CURRENT.with(Cell::get);
+    if additional > limits.repeated_len.saturating_sub(len) {
+        return Err(DecodeError::new("repeated field length limit exceeded"));
+    }
+    charge(limits, additional.saturating_mul(element_size))
+}
+
+/// Returns how many of `additional` elements of `element_size` bytes can be reserved for in a
+/// repeated field of `len` elements within the installed limits, and at least one.
+#[cfg(feature = "std")]
+#[inline]
+pub(crate) fn clamp_reservation(len: usize, additional: usize, element_size: usize) -> usize {
+    let limits = CURRENT.with(Cell::get);
+    additional
+        .min(limits.repeated_len.saturating_sub(len))
+        .min(limits.allocation / element_size.max(1))
+        .max(1)
+}
+
+/// Charges `size` bytes to the installed allocation limit.
+#[cfg(feature = "std")]
+#[inline]
+pub(crate) fn check_allocation(size: usize) -> Result<(), DecodeError> {
+    charge(CURRENT.with(Cell::get), size)
+}
+
+#[cfg(feature = "std")]
+#[inline(never)]
+fn charge(limits: Limits, size: usize) -> Result<(), DecodeError> {
+    if size > limits.allocation {
+        return Err(DecodeError::new("allocation limit exceeded"));
+    }
+    CURRENT.with(|current| {
+        current.set(Limits {
+            allocation: limits.allocation - size,
+            ..limits
+        })
+    });
+    Ok(())
+}
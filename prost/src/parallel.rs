@@ -0,0 +1,160 @@
+use std::panic;
+use std::thread;
+
+use crate::encoding::{decode_key, decode_varint, message, DecodeContext, WireType};
+use crate::{DecodeError, Message};
+
+/// The minimum number of encoded bytes decoded by each thread. Smaller inputs are not worth the
+/// cost of starting a thread.
+const MIN_BYTES_PER_THREAD: usize = 64 * 1024;
+
+/// Decodes a message from a buffer, and merges it into `message`, decoding the elements of one
+/// of its repeated message fields in parallel.
+///
+/// The decoded message is the same as with [`Message::merge`]. Errors differ in one way: the
+/// repeated field is only known by its tag, so the error of an invalid element does not name the
+/// message and field it belongs to, as [`Message::merge`] does. The errors of other fields are
+/// unchanged.
+///
+/// The buffer is scanned once: the other fields of the message are merged as they are found, and
+/// the locations of the elements of the repeated field with the given tag are recorded. The elements are then decoded on all available
+/// cores, directly into their place at the end of the `Vec` returned by `field`, in their encoded
+/// order.
+///
+/// This pays off for messages with a large repeated field, such as a batch of records. Small
+/// inputs are decoded on the current thread. If an element fails to decode, the error of the
+/// first invalid element is returned, and no elements are added to the field.
+///
+/// The elements are also decoded on the current thread when it is decoding with
+/// [`DecodeOptions`](crate::DecodeOptions), or within [`with_interner`](crate::with_interner):
+/// their limits and interner are installed for the current thread only, and they apply to every
+/// element regardless of the number of cores. The message is decoded without a
+/// [`Projection`](crate::Projection).
+///
+/// # Examples
+///
+/// ```rust
+/// # use prost::Message;
+/// # #[derive(Message)]
+/// # struct Record {
+/// #     #[prost(uint64, tag = "1")]
+/// #     id: u64,
+/// # }
+/// # #[derive(Message)]
+/// # struct Batch {
+/// #     #[prost(message, repeated, tag = "1")]
+/// #     records: Vec<Record>,
+/// # }
+/// let records = (0..1000).map(|id| Record { id }).collect();
+/// let encoded = Batch { records }.encode_to_vec();
+///
+/// let mut batch = Batch::default();
+/// prost::merge_repeated_parallel(&mut batch, &encoded, 1, |batch| &mut batch.records).unwrap();
+/// assert_eq!(batch.records.len(), 1000);
+/// ```
+pub fn merge_repeated_parallel<M, E, F>(
+    message: &mut M,
+    buf: &[u8],
+    tag: u32,
+    field: F,
+) -> Result<(), DecodeError>
+where
+    M: Message,
+    E: Message + Default + Send,
+    F: FnOnce(&mut M) -> &mut Vec<E>,
+{
+    let ctx = DecodeContext::default();
+
+    // The offsets of the length delimiters of the elements.
+    let mut starts = Vec::new();
+    let mut rest = buf;
+    while !rest.is_empty() {
+        let (field_tag, wire_type) = decode_key(&mut rest)?;
+        if field_tag == tag && wire_type == WireType::LengthDelimited {
+            starts.push(buf.len() - rest.len());
+            let len = decode_varint(&mut rest)?;
+            if len > rest.len() as u64 {
+                return Err(DecodeError::new("buffer underflow"));
+            }
+            rest = &rest[len as usize..];
+        } else {
+            message.merge_field(field_tag, wire_type, &mut rest, ctx.clone())?;
+        }
+    }
+
+    let values = field(message);
+    let offset = values.len();
+    values.resize_with(offset + starts.len(), E::default);
+    let result = if ctx.limited() || crate::intern::installed() {
+        merge_chunk(&mut values[offset..], buf, &starts, &ctx)
+    } else {
+        merge_elements(&mut values[offset..], buf, &starts, &ctx)
+    };
+    if result.is_err() {
+        values.truncate(offset);
+    }
+    result
+}
+
+/// Decodes the elements starting at the given offsets of the buffer into `values`, splitting them
+/// between threads.
+fn merge_elements<E>(
+    values: &mut [E],
+    buf: &[u8],
+    starts: &[usize],
+    ctx: &DecodeContext,
+) -> Result<(), DecodeError>
+where
+    E: Message + Send,
+{
+    // Querying the number of cores is a system call, so rule out small inputs first.
+    let mut threads = (buf.len() / MIN_BYTES_PER_THREAD).min(starts.len());
+    if threads > 1 {
+        threads = thread::available_parallelism().map_or(1, |cores| threads.min(cores.get()));
+    }
+    if threads <= 1 {
+        return merge_chunk(values, buf, starts, ctx);
+    }
+
+    let chunk_len = (starts.len() + threads - 1) / threads;
+    let mut chunks = values.chunks_mut(chunk_len).zip(starts.chunks(chunk_len));
+    let (first_values, first_starts) = chunks.next().unwrap();
+    thread::scope(|scope| {
+        let handles = chunks
+            .map(|(values, starts)| {
+                let ctx = ctx.clone();
+                scope.spawn(move || merge_chunk(values, buf, starts, &ctx))
+            })
+            .collect::<Vec<_>>();
+        let first = merge_chunk(first_values, buf, first_starts, ctx);
+        // Join every thread before returning, and report the error of the first invalid element.
+        handles.into_iter().fold(first, |result, handle| {
+            let chunk = handle
+                .join()
+                .unwrap_or_else(|payload| panic::resume_unwind(payload));
+            result.and(chunk)
+        })
+    })
+}
+
+/// Decodes the elements starting at the given offsets of the buffer into `values`, with the
+/// context of the message they belong to, like `message::merge_repeated`.
+fn merge_chunk<E>(
+    values: &mut [E],
+    buf: &[u8],
+    starts: &[usize],
+    ctx: &DecodeContext,
+) -> Result<(), DecodeError>
+where
+    E: Message,
+{
+    for (value, &start) in values.iter_mut().zip(starts) {
+        message::merge(
+            WireType::LengthDelimited,
+            value,
+            &mut &buf[start..],
+            ctx.clone(),
+        )?;
+    }
+    Ok(())
+}
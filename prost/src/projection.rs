@@ -0,0 +1,196 @@
+//! Support for decoding a subset of the fields of a message.
+
+use std::cell::RefCell;
+use std::sync::Arc;
+
+use crate::encoding::DecodeContext;
+use crate::{DecodeError, Message};
+
+/// The node of a field which is selected with all of its fields.
+const ALL_FIELDS: u32 = 0;
+
+thread_local! {
+    /// The nodes of the projection being decoded on this thread.
+    static CURRENT: RefCell<Option<Arc<[Node]>>> = RefCell::new(None);
+}
+
+/// A selection of fields to decode, as a tree of field tags.
+///
+/// Decoding a message with [`Message::decode_projected`] merges only the selected fields, and
+/// skips all others without decoding them. A selected message field can select some of its own
+/// fields, down to any depth; a message field which is selected without any of its fields is
+/// decoded completely. When only a few fields of large messages are needed, this saves most of
+/// the decoding work.
+///
+/// Fields are selected by path. A path lists the tags of the fields leading from the message to
+/// the selected field; with [`from_field_paths`](Projection::from_field_paths), a path lists
+/// the field names separated by dots, as in a `google.protobuf.FieldMask`. The fields of a
+/// repeated message field are selected in each of its elements. Fields within a map, a oneof or
+/// a lazily decoded message can not be selected: these are decoded completely when selected.
+///
+/// # Examples
+///
+/// ```rust
+/// # use prost::{Message, Projection};
+/// # #[derive(Message)]
+/// # struct Event {
+/// #     #[prost(string, tag = "1")]
+/// #     name: String,
+/// #     #[prost(message, optional, tag = "2")]
+/// #     source: Option<Source>,
+/// #     #[prost(bytes = "vec", tag = "3")]
+/// #     payload: Vec<u8>,
+/// # }
+/// # #[derive(PartialEq, Message)]
+/// # struct Source {
+/// #     #[prost(string, tag = "1")]
+/// #     host: String,
+/// #     #[prost(uint32, tag = "2")]
+/// #     port: u32,
+/// # }
+/// let event = Event {
+///     name: "login".to_string(),
+///     source: Some(Source { host: "example.com".to_string(), port: 443 }),
+///     payload: vec![0; 1024],
+/// };
+/// let encoded = event.encode_to_vec();
+///
+/// let projection = Projection::from_field_paths::<Event, _>(["name", "source.port"]).unwrap();
+/// let event = Event::decode_projected(&*encoded, &projection).unwrap();
+/// assert_eq!(event.name, "login");
+/// assert_eq!(event.source, Some(Source { host: String::new(), port: 443 }));
+/// assert!(event.payload.is_empty());
+/// ```
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct Projection {
+    nodes: Arc<[Node]>,
+}
+
+/// The selected fields of a message: the tag of each field, sorted, and the number of the node
+/// selecting its fields, or `ALL_FIELDS`. Node `n` is at index `n - 1`.
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+struct Node {
+    fields: Vec<(u32, u32)>,
+}
+
+impl Projection {
+    /// Creates a projection which selects the fields with the given paths of tags.
+    ///
+    /// An empty path selects all fields.
+    pub fn new<I, P>(paths: I) -> Projection
+    where
+        I: IntoIterator<Item = P>,
+        P: AsRef<[u32]>,
+    {
+        let mut nodes = vec![Node::default()];
+        for path in paths {
+            let path = path.as_ref();
+            if path.is_empty() {
+                return Projection::select_all();
+            }
+
+            let mut node = 1;
+            for (depth, &tag) in path.iter().enumerate() {
+                let last = depth + 1 == path.len();
+                let fields = &mut nodes[node as usize - 1].fields;
+                let child = match fields.binary_search_by_key(&tag, |&(tag, _)| tag) {
+                    // The field is already selected completely.
+                    Ok(index) if fields[index].1 == ALL_FIELDS => break,
+                    Ok(index) if last => {
+                        fields[index].1 = ALL_FIELDS;
+                        break;
+                    }
+                    Ok(index) => fields[index].1,
+                    Err(index) if last => {
+                        fields.insert(index, (tag, ALL_FIELDS));
+                        break;
+                    }
+                    Err(index) => {
+                        nodes.push(Node::default());
+                        let child = nodes.len() as u32;
+                        nodes[node as usize - 1].fields.insert(index, (tag, child));
+                        child
+                    }
+                };
+                node = child;
+            }
+        }
+        Projection {
+            nodes: nodes.into(),
+        }
+    }
+
+    /// Creates a projection which selects the fields of the message `M` with the given paths of
+    /// field names, such as `"source.port"`.
+    ///
+    /// Returns an error if a path does not name a field of the message, or continues past a
+    /// field which is not a message. Field names are the names of the fields in the `.proto`
+    /// file, as in a `FieldMask`. prost-build gives them with a `#[prost(name = "...")]`
+    /// attribute when they differ from the snake case names of the generated struct; fields of
+    /// structs deriving `Message` by hand are otherwise named by their Rust name.
+    pub fn from_field_paths<M, I>(paths: I) -> Result<Projection, DecodeError>
+    where
+        M: Message,
+        I: IntoIterator,
+        I::Item: AsRef<str>,
+    {
+        let mut tag_paths = Vec::new();
+        for path in paths {
+            let path = path.as_ref();
+            let mut tags = Vec::new();
+            if !M::resolve_field_path(path, &mut tags) {
+                return Err(DecodeError::new(format!("invalid field path: {}", path)));
+            }
+            tag_paths.push(tags);
+        }
+        Ok(Projection::new(tag_paths))
+    }
+
+    /// Returns a projection which selects all fields.
+    fn select_all() -> Projection {
+        Projection {
+            nodes: Arc::from([]),
+        }
+    }
+}
+
+/// Decodes with the given projection: calls `decode` with a context at the root of the
+/// projection, while the projection is installed for the current thread.
+pub(crate) fn decode_projected<R>(
+    projection: &Projection,
+    decode: impl FnOnce(DecodeContext) -> R,
+) -> R {
+    if projection.nodes.is_empty() {
+        return decode(DecodeContext::default());
+    }
+
+    /// Restores the previously installed projection, even if decoding panics.
+    struct Restore(Option<Arc<[Node]>>);
+
+    impl Drop for Restore {
+        fn drop(&mut self) {
+            CURRENT.with(|current| *current.borrow_mut() = self.0.take());
+        }
+    }
+
+    let _restore = Restore(CURRENT.with(|current| current.replace(Some(projection.nodes.clone()))));
+    decode(DecodeContext::projected(1))
+}
+
+/// Returns `None` if the field with the given tag is not selected by the node of the installed
+/// projection, and otherwise the node selecting its fields.
+pub(crate) fn select_field(node: u32, tag: u32) -> Option<u32> {
+    CURRENT.with(|current| {
+        let current = current.borrow();
+        // A context which outlives its projection selects all fields.
+        let fields = match current
+            .as_ref()
+            .and_then(|nodes| nodes.get(node as usize - 1))
+        {
+            Some(node) => &node.fields,
+            None => return Some(ALL_FIELDS),
+        };
+        let index = fields.binary_search_by_key(&tag, |&(tag, _)| tag).ok()?;
+        Some(fields[index].1)
+    })
+}
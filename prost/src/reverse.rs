@@ -0,0 +1,149 @@
+#[cfg(not(feature = "std"))]
+use alloc::{vec, vec::Vec};
+
+use bytes::BufMut;
+
+use crate::encoding::{encode_varint, encoded_len_varint, WireType};
+
+/// A buffer which is written back to front, for encoding messages in a single pass.
+///
+/// Encoding a message with [`Message::encode`](crate::Message::encode) first computes the
+/// encoded length of the whole message, because every nested message is preceded by its length.
+/// [`Message::encode_reverse`](crate::Message::encode_reverse) instead writes the fields of a
+/// message from last to first, into a `ReverseBuf` which grows towards the front. When a nested
+/// message has been written, its length is known, and is written in front of it: no separate
+/// sizing pass is needed. Only fields which are not messages are sized, just before they are
+/// written, which is cheap.
+///
+/// Encoding into a non-empty `ReverseBuf` writes the message in front of its current contents.
+///
+/// # Examples
+///
+/// ```rust
+/// # use prost::{Message, ReverseBuf};
+/// # #[derive(Message)]
+/// # struct Node {
+/// #     #[prost(string, tag = "1")]
+/// #     name: String,
+/// #     #[prost(message, repeated, tag = "2")]
+/// #     children: Vec<Node>,
+/// # }
+/// let leaf = Node { name: "leaf".to_string(), children: Vec::new() };
+/// let root = Node { name: "root".to_string(), children: vec![leaf] };
+///
+/// let mut buf = ReverseBuf::new();
+/// root.encode_reverse(&mut buf);
+/// assert_eq!(buf.as_slice(), root.encode_to_vec());
+/// ```
+#[derive(Clone, Debug, Default)]
+pub struct ReverseBuf {
+    /// The storage of the buffer, whose written bytes are at the end.
+    buf: Vec<u8>,
+    /// The index of the first written byte.
+    start: usize,
+}
+
+impl ReverseBuf {
+    /// The capacity of the buffer after the first write.
+    const MIN_CAPACITY: usize = 64;
+
+    /// Creates a new, empty `ReverseBuf`.
+    pub const fn new() -> ReverseBuf {
+        ReverseBuf {
+            buf: Vec::new(),
+            start: 0,
+        }
+    }
+
+    /// Creates a new, empty `ReverseBuf` which can hold `capacity` bytes without growing.
+    pub fn with_capacity(capacity: usize) -> ReverseBuf {
+        ReverseBuf {
+            buf: vec![0; capacity],
+            start: capacity,
+        }
+    }
+
+    /// Returns the number of bytes written to the buffer.
+    pub fn len(&self) -> usize {
+        self.buf.len() - self.start
+    }
+
+    /// Returns `true` if no bytes have been written to the buffer.
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Returns the written bytes.
+    pub fn as_slice(&self) -> &[u8] {
+        &self.buf[self.start..]
+    }
+
+    /// Removes the written bytes, keeping the capacity of the buffer.
+    pub fn clear(&mut self) {
+        self.start = self.buf.len();
+    }
+
+    /// Returns the written bytes, moved to the front of the buffer's storage.
+    pub fn into_vec(mut self) -> Vec<u8> {
+        self.buf.drain(..self.start);
+        self.buf
+    }
+
+    /// Writes `src` in front of the written bytes.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    #[inline]
+    pub fn prepend_slice(&mut self, src: &[u8]) {
+        self.prepend_with(src.len(), |buf| buf.put_slice(src));
+    }
+
+    /// Writes a varint in front of the written bytes.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    #[inline]
+    pub fn prepend_varint(&mut self, value: u64) {
+        self.prepend_with(encoded_len_varint(value), |buf| encode_varint(value, buf));
+    }
+
+    /// Writes a field key in front of the written bytes.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    #[inline]
+    pub fn prepend_key(&mut self, tag: u32, wire_type: WireType) {
+        self.prepend_varint(u64::from((tag << 3) | wire_type as u32));
+    }
+
+    /// Writes `len` bytes in front of the written bytes, by calling `f` with a buffer of exactly
+    /// `len` bytes, which it must fill from front to back.
+    ///
+    /// Meant to be used only by `Message` implementations.
+    #[doc(hidden)]
+    #[inline]
+    pub fn prepend_with(&mut self, len: usize, f: impl FnOnce(&mut &mut [u8])) {
+        if len > self.start {
+            self.grow(len);
+        }
+        let start = self.start - len;
+        let mut buf = &mut self.buf[start..self.start];
+        f(&mut buf);
+        debug_assert!(buf.is_empty(), "prepended value is shorter than its length");
+        self.start = start;
+    }
+
+    /// Grows the buffer to have room for at least `additional` more bytes in front of the written
+    /// bytes.
+    #[cold]
+    fn grow(&mut self, additional: usize) {
+        let len = self.len();
+        let capacity = (self.buf.len() * 2)
+            .max(len + additional)
+            .max(ReverseBuf::MIN_CAPACITY);
+        let mut buf = vec![0; capacity];
+        buf[capacity - len..].copy_from_slice(self.as_slice());
+        self.buf = buf;
+        self.start = capacity - len;
+    }
+}
@@ -0,0 +1,179 @@
+use bytes::{Buf, BytesMut};
+
+use crate::encoding::{decode_key, decode_varint, DecodeContext, WireType};
+use crate::instrument;
+use crate::{DecodeError, Message};
+
+/// An incremental decoder for a stream of length-delimited messages.
+///
+/// Bytes are pushed into the decoder as they arrive, in chunks of any size, and complete messages
+/// are taken out with [`next_message`](StreamDecoder::next_message). Each message is expected to
+/// be prefixed with its length, as written by
+/// [`Message::encode_length_delimited`](crate::Message::encode_length_delimited).
+///
+/// The decoder does not wait for a whole message to arrive: each top-level field of the message
+/// is merged as soon as its bytes are complete, and its bytes are released. The decoder
+/// therefore only buffers the field which is currently arriving, rather than the whole message.
+/// Group fields are the exception, and are buffered until the end of the message.
+///
+/// Messages longer than the maximum frame length are rejected as soon as their length
+/// delimiter is decoded. After an error, the state of the stream is unknown, and the decoder
+/// should not be used any further.
+///
+/// # Examples
+///
+/// ```rust
+/// # use prost::{Message, StreamDecoder};
+/// # #[derive(Message)]
+/// # struct Event {
+/// #     #[prost(string, tag = "1")]
+/// #     name: String,
+/// # }
+/// let mut encoded = Vec::new();
+/// Event { name: "first".to_string() }.encode_length_delimited(&mut encoded).unwrap();
+/// Event { name: "second".to_string() }.encode_length_delimited(&mut encoded).unwrap();
+///
+/// let mut decoder = StreamDecoder::<Event>::new(1024);
+/// let mut names = Vec::new();
+/// for chunk in encoded.chunks(3) {
+///     decoder.push(chunk);
+///     while let Some(event) = decoder.next_message().unwrap() {
+///         names.push(event.name);
+///     }
+/// }
+/// assert_eq!(names, ["first", "second"]);
+/// assert!(decoder.is_empty());
+/// ```
+#[derive(Debug)]
+pub struct StreamDecoder<M> {
+    /// The bytes which have been pushed, but not yet decoded.
+    buf: BytesMut,
+    /// The maximum length of a message, without its length delimiter.
+    max_frame_len: usize,
+    /// The message being decoded, the number of its bytes which have not been decoded yet, and
+    /// the instrumentation of its decoding.
+    frame: Option<(M, usize, instrument::Decode)>,
+}
+
+impl<M> StreamDecoder<M>
+where
+    M: Message + Default,
+{
+    /// Creates a new `StreamDecoder`, which rejects messages longer than `max_frame_len` bytes.
+    pub fn new(max_frame_len: usize) -> StreamDecoder<M> {
+        StreamDecoder {
+            buf: BytesMut::new(),
+            max_frame_len,
+            frame: None,
+        }
+    }
+
+    /// Pushes the next chunk of the stream into the decoder.
+    pub fn push(&mut self, chunk: &[u8]) {
+        self.buf.extend_from_slice(chunk);
+    }
+
+    /// Returns `true` if the decoder holds no partially received message.
+    pub fn is_empty(&self) -> bool {
+        self.buf.is_empty() && self.frame.is_none()
+    }
+
+    /// Decodes as much of the pushed bytes as possible, and returns the next complete message.
+    ///
+    /// Returns `None` if more bytes are needed to complete the next message.
+    pub fn next_message(&mut self) -> Result<Option<M>, DecodeError> {
+        loop {
+            let (message, remaining, _) = match self.frame {
+                Some(ref mut frame) => frame,
+                None => {
+                    let len = match complete_varint_len(&self.buf) {
+                        Some(len) => len,
+                        None => return Ok(None),
+                    };
+                    let frame_len = decode_varint(&mut &self.buf[..len])?;
+                    if frame_len > self.max_frame_len as u64 {
+                        return Err(DecodeError::new(
+                            "message length exceeds maximum frame length",
+                        ));
+                    }
+                    self.buf.advance(len);
+                    let frame_len = frame_len as usize;
+                    let instrument = instrument::Decode::start_frame(frame_len);
+                    self.frame.insert((M::default(), frame_len, instrument))
+                }
+            };
+
+            if *remaining == 0 {
+                return Ok(self.frame.take().map(|(message, _, instrument)| {
+                    instrument.finish_frame::<M>();
+                    message
+                }));
+            }
+
+            let available = &self.buf[..self.buf.len().min(*remaining)];
+            let field_len = match complete_field_len(available, *remaining)? {
+                Some(len) => len,
+                None => return Ok(None),
+            };
+
+            let mut field = self.buf.split_to(field_len).freeze();
+            *remaining -= field_len;
+            let ctx = DecodeContext::default();
+            while field.has_remaining() {
+                let (tag, wire_type) = decode_key(&mut field)?;
+                message.merge_field(tag, wire_type, &mut field, ctx.clone())?;
+            }
+        }
+    }
+}
+
+/// Returns the length of the varint at the start of the buffer, or `None` if the buffer ends
+/// before the varint does. An invalid varint is reported as ten bytes long.
+fn complete_varint_len(buf: &[u8]) -> Option<usize> {
+    match buf.iter().take(10).position(|&byte| byte < 0x80) {
+        Some(last) => Some(last + 1),
+        None if buf.len() >= 10 => Some(10),
+        None => None,
+    }
+}
+
+/// Returns the length of the top-level field at the start of `available`, including its key, or
+/// `None` if the buffer does not hold the complete field yet. `remaining` is the number of bytes
+/// left in the message.
+///
+/// Group fields, which can only be delimited by decoding them, extend to the end of the message.
+fn complete_field_len(available: &[u8], remaining: usize) -> Result<Option<usize>, DecodeError> {
+    let key_len = match complete_varint_len(available) {
+        Some(len) => len,
+        None if available.len() == remaining => {
+            return Err(DecodeError::new("delimited length exceeded"))
+        }
+        None => return Ok(None),
+    };
+    let (_, wire_type) = decode_key(&mut &available[..key_len])?;
+    let value = &available[key_len..];
+
+    let value_len = match wire_type {
+        WireType::Varint => complete_varint_len(value).map(|len| len as u64),
+        WireType::SixtyFourBit => Some(8),
+        WireType::ThirtyTwoBit => Some(4),
+        WireType::LengthDelimited => match complete_varint_len(value) {
+            Some(len) => Some((len as u64).saturating_add(decode_varint(&mut &value[..len])?)),
+            None => None,
+        },
+        WireType::StartGroup | WireType::EndGroup => Some((remaining - key_len) as u64),
+    };
+
+    match value_len {
+        Some(value_len) if value_len > (remaining - key_len) as u64 => {
+            Err(DecodeError::new("delimited length exceeded"))
+        }
+        Some(value_len) if key_len + value_len as usize <= available.len() => {
+            Ok(Some(key_len + value_len as usize))
+        }
+        // The field is incomplete, but fits in the message.
+        Some(_) => Ok(None),
+        None if available.len() == remaining => Err(DecodeError::new("delimited length exceeded")),
+        None => Ok(None),
+    }
+}
@@ -0,0 +1,205 @@
+//! Support for preserving the unknown fields of a message.
+
+#[cfg(not(feature = "std"))]
+use alloc::vec::Vec;
+
+use bytes::{Buf, BufMut, Bytes, BytesMut};
+
+use crate::encoding::{
+    decode_key, decode_varint, encode_key, encode_varint, encoded_len_varint, key_len, skip_field,
+    DecodeContext, EncodeBuf, WireType,
+};
+use crate::DecodeError;
+
+/// The fields of a message which are not part of its definition.
+///
+/// A message decoded with a newer version of its schema may contain fields which the generated
+/// code does not know about. These are normally skipped, and lost when the message is encoded
+/// again. A message containing a field annotated with `#[prost(unknown_fields)]` instead stores
+/// them in an `UnknownFields`, and encodes them after its known fields, so that they survive a
+/// round trip through code built from an older schema.
+///
+/// The unknown fields are stored in their encoded form, and are not parsed beyond finding their
+/// length. When the message is decoded from a [`Bytes`] buffer, each field is stored as a slice
+/// of that buffer, without copying; other buffers are copied.
+///
+/// # Examples
+///
+/// ```rust
+/// # use prost::{Message, UnknownFields};
+/// # #[derive(Message)]
+/// # struct New {
+/// #     #[prost(string, tag = "1")]
+/// #     name: String,
+/// #     #[prost(uint64, tag = "2")]
+/// #     size: u64,
+/// # }
+/// # #[derive(Message)]
+/// # struct Old {
+/// #     #[prost(string, tag = "1")]
+/// #     name: String,
+/// #     #[prost(unknown_fields)]
+/// #     unknown_fields: UnknownFields,
+/// # }
+/// let new = New { name: "file".to_string(), size: 42 };
+/// let encoded = prost::bytes::Bytes::from(new.encode_to_vec());
+///
+/// let old = Old::decode(encoded.clone()).unwrap();
+/// assert_eq!(old.unknown_fields.len(), 1);
+/// assert_eq!(old.encode_to_vec(), encoded);
+/// ```
+#[derive(Clone, Debug, Default, PartialEq, Eq, Hash)]
+pub struct UnknownFields {
+    fields: Vec<UnknownField>,
+}
+
+/// An unknown field: its key, and its encoded value.
+#[derive(Clone, Debug, PartialEq, Eq, Hash)]
+struct UnknownField {
+    tag: u32,
+    wire_type: WireType,
+    /// The value as encoded after the key: varints are kept in their encoded form, length
+    /// delimited values include their length, and groups include their end group key.
+    value: Bytes,
+}
+
+impl UnknownFields {
+    /// Creates a new, empty `UnknownFields`.
+    pub const fn new() -> UnknownFields {
+        UnknownFields { fields: Vec::new() }
+    }
+
+    /// Returns the number of unknown fields.
+    pub fn len(&self) -> usize {
+        self.fields.len()
+    }
+
+    /// Returns `true` if there are no unknown fields.
+    pub fn is_empty(&self) -> bool {
+        self.fields.is_empty()
+    }
+
+    /// Removes all unknown fields.
+    pub fn clear(&mut self) {
+        self.fields.clear()
+    }
+
+    /// Returns the tag, wire type and encoded value of each unknown field, in decoding order.
+    ///
+    /// The value is encoded as it follows the key: length delimited values include their length,
+    /// and groups include their end group key.
+    pub fn iter(&self) -> impl Iterator<Item = (u32, WireType, &Bytes)> + '_ {
+        self.fields
+            .iter()
+            .map(|field| (field.tag, field.wire_type, &field.value))
+    }
+
+    /// Stores the field whose key has just been decoded from `buf`.
+    pub fn merge_field(
+        &mut self,
+        tag: u32,
+        wire_type: WireType,
+        buf: &mut (impl Buf + ?Sized),
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError> {
+        // Find the end of the value in the current chunk, which holds the whole value unless the
+        // buffer is not contiguous.
+        let mut chunk = buf.chunk();
+        ctx.check_allocation(core::mem::size_of::<UnknownField>())?;
+        let value = match skip_field(wire_type, tag, &mut chunk, ctx.clone()) {
+            Ok(()) => {
+                let len = buf.chunk().len() - chunk.len();
+                ctx.check_allocation(len)?;
+                buf.copy_to_bytes(len)
+            }
+            Err(error) if buf.chunk().len() == buf.remaining() => return Err(error),
+            Err(_) => {
+                let mut value = BytesMut::new();
+                copy_value(wire_type, tag, buf, &mut value, ctx)?;
+                value.freeze()
+            }
+        };
+        self.fields.push(UnknownField {
+            tag,
+            wire_type,
+            value,
+        });
+        Ok(())
+    }
+
+    /// Encodes the unknown fields.
+    ///
+    /// A field of at least [`VectoredBuf`](crate::VectoredBuf)'s minimum segment length is
+    /// referenced rather than copied.
+    pub fn encode_raw(&self, buf: &mut (impl EncodeBuf + ?Sized)) {
+        for field in &self.fields {
+            encode_key(field.tag, field.wire_type, buf);
+            buf.append_bytes(&field.value);
+        }
+    }
+
+    /// Returns the encoded length of the unknown fields.
+    pub fn encoded_len(&self) -> usize {
+        self.fields
+            .iter()
+            .map(|field| key_len(field.tag) + field.value.len())
+            .sum()
+    }
+}
+
+/// Copies the encoded value of a field from a non-contiguous buffer, charging the copied bytes to
+/// the limits of the installed [`DecodeOptions`](crate::DecodeOptions).
+fn copy_value(
+    wire_type: WireType,
+    tag: u32,
+    buf: &mut (impl Buf + ?Sized),
+    value: &mut BytesMut,
+    ctx: DecodeContext,
+) -> Result<(), DecodeError> {
+    ctx.limit_reached()?;
+    let len = match wire_type {
+        WireType::Varint => {
+            let varint = decode_varint(buf)?;
+            ctx.check_allocation(encoded_len_varint(varint))?;
+            encode_varint(varint, value);
+            0
+        }
+        WireType::ThirtyTwoBit => 4,
+        WireType::SixtyFourBit => 8,
+        WireType::LengthDelimited => {
+            let len = decode_varint(buf)?;
+            ctx.check_allocation(encoded_len_varint(len))?;
+            encode_varint(len, value);
+            len
+        }
+        WireType::StartGroup => loop {
+            let (inner_tag, inner_wire_type) = decode_key(buf)?;
+            ctx.check_allocation(key_len(inner_tag))?;
+            encode_key(inner_tag, inner_wire_type, value);
+            match inner_wire_type {
+                WireType::EndGroup => {
+                    if inner_tag != tag {
+                        return Err(DecodeError::new("unexpected end group tag"));
+                    }
+                    break 0;
+                }
+                _ => copy_value(
+                    inner_wire_type,
+                    inner_tag,
+                    buf,
+                    value,
+                    ctx.enter_recursion(),
+                )?,
+            }
+        },
+        WireType::EndGroup => return Err(DecodeError::new("unexpected end group tag")),
+    };
+
+    if len > buf.remaining() as u64 {
+        return Err(DecodeError::new("buffer underflow"));
+    }
+
+    ctx.check_allocation(len as usize)?;
+    value.put(buf.take(len as usize));
+    Ok(())
+}
@@ -0,0 +1,152 @@
+#[cfg(not(feature = "std"))]
+use alloc::vec::Vec;
+#[cfg(feature = "std")]
+use std::io::IoSlice;
+
+use bytes::buf::UninitSlice;
+use bytes::{Buf, BufMut, Bytes, BytesMut};
+
+/// A buffer which encodes large `Bytes` fields by reference.
+///
+/// Encoding a message into a contiguous buffer copies every `bytes` field into it. When a
+/// message is encoded into a `VectoredBuf` instead, small fields are still written to a scratch
+/// buffer, but `Bytes` values of at least [`min_segment_len`](VectoredBuf::with_min_segment_len)
+/// bytes are not copied: the buffer keeps a reference to them as a separate segment. The
+/// resulting segments can be written with vectored I/O, such as `Write::write_vectored`, using
+/// [`io_slices`](VectoredBuf::io_slices).
+///
+/// Only `bytes` fields represented as [`Bytes`] can be referenced; other large values are copied.
+///
+/// # Examples
+///
+/// ```rust
+/// # use prost::{bytes::Bytes, Message, VectoredBuf};
+/// # #[derive(Message)]
+/// # struct Blob {
+/// #     #[prost(string, tag = "1")]
+/// #     name: String,
+/// #     #[prost(bytes = "bytes", tag = "2")]
+/// #     data: Bytes,
+/// # }
+/// let data = Bytes::from(vec![0u8; 1 << 20]);
+/// let blob = Blob { name: "blob".to_string(), data: data.clone() };
+///
+/// let mut buf = VectoredBuf::new();
+/// blob.encode(&mut buf).unwrap();
+/// let segments = buf.into_segments();
+///
+/// // The name and the length of the data are copied, the data itself is referenced.
+/// assert_eq!(segments.len(), 2);
+/// assert_eq!(segments[1].as_ptr(), data.as_ptr());
+/// ```
+#[derive(Clone, Debug)]
+pub struct VectoredBuf {
+    /// The completed segments, in order.
+    segments: Vec<Bytes>,
+    /// The total length of the completed segments.
+    segments_len: usize,
+    /// The bytes written since the last segment.
+    scratch: BytesMut,
+    /// The minimum length of a `Bytes` value which is referenced instead of copied.
+    min_segment_len: usize,
+}
+
+impl VectoredBuf {
+    /// The default minimum length of a referenced `Bytes` value. Shorter values are cheaper to
+    /// copy than to track as a separate segment.
+    pub const DEFAULT_MIN_SEGMENT_LEN: usize = 4096;
+
+    /// Creates a new, empty `VectoredBuf`.
+    pub fn new() -> VectoredBuf {
+        VectoredBuf::with_min_segment_len(VectoredBuf::DEFAULT_MIN_SEGMENT_LEN)
+    }
+
+    /// Creates a new, empty `VectoredBuf`, which references `Bytes` values of at least
+    /// `min_segment_len` bytes.
+    pub fn with_min_segment_len(min_segment_len: usize) -> VectoredBuf {
+        VectoredBuf {
+            segments: Vec::new(),
+            segments_len: 0,
+            scratch: BytesMut::new(),
+            min_segment_len,
+        }
+    }
+
+    /// Returns the total number of bytes written to the buffer.
+    pub fn len(&self) -> usize {
+        self.segments_len + self.scratch.len()
+    }
+
+    /// Returns `true` if no bytes have been written to the buffer.
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Returns the written bytes as slices, in order, for vectored writes.
+    #[cfg(feature = "std")]
+    pub fn io_slices(&self) -> Vec<IoSlice<'_>> {
+        self.segments
+            .iter()
+            .map(|segment| &segment[..])
+            .chain(Some(&self.scratch[..]).filter(|scratch| !scratch.is_empty()))
+            .map(IoSlice::new)
+            .collect()
+    }
+
+    /// Returns the written bytes as a list of segments, in order.
+    pub fn into_segments(mut self) -> Vec<Bytes> {
+        self.finish_segment();
+        self.segments
+    }
+
+    /// Ends the current scratch segment, if it is not empty.
+    fn finish_segment(&mut self) {
+        if !self.scratch.is_empty() {
+            let segment = self.scratch.split().freeze();
+            self.push_segment(segment);
+        }
+    }
+
+    fn push_segment(&mut self, segment: Bytes) {
+        self.segments_len += segment.len();
+        self.segments.push(segment);
+    }
+}
+
+impl Default for VectoredBuf {
+    fn default() -> VectoredBuf {
+        VectoredBuf::new()
+    }
+}
+
+unsafe impl BufMut for VectoredBuf {
+    fn remaining_mut(&self) -> usize {
+        usize::MAX - self.len()
+    }
+
+    unsafe fn advance_mut(&mut self, cnt: usize) {
+        self.scratch.advance_mut(cnt)
+    }
+
+    fn chunk_mut(&mut self) -> &mut UninitSlice {
+        self.scratch.chunk_mut()
+    }
+
+    fn put<T: Buf>(&mut self, mut src: T)
+    where
+        Self: Sized,
+    {
+        if src.remaining() < self.min_segment_len {
+            self.scratch.put(src);
+        } else {
+            // `Bytes::copy_to_bytes` returns a reference to the same data, without copying it.
+            self.finish_segment();
+            let len = src.remaining();
+            self.push_segment(src.copy_to_bytes(len));
+        }
+    }
+
+    fn put_slice(&mut self, src: &[u8]) {
+        self.scratch.extend_from_slice(src);
+    }
+}
@@ -0,0 +1,79 @@
+#[cfg(not(feature = "std"))]
+use alloc::boxed::Box;
+
+use crate::encoding::{decode_key, message_view, DecodeContext, WireType};
+use crate::DecodeError;
+
+/// A borrowed view of a Protocol Buffers message.
+///
+/// A view decodes directly from an input `&'a [u8]`: `string` and `bytes` fields are represented as
+/// `&'a str` and `&'a [u8]` slices of the input, so decoding a view does not allocate for them.
+/// Repeated fields are still collected in a `Vec`.
+///
+/// Views are decode-only, and are typically generated by `prost-build` next to the owned message
+/// type (see `Config::message_view`), or derived with `#[derive(MessageView)]`.
+pub trait MessageView<'a>: Default {
+    /// Decodes a field from a buffer, and merges it into `self`.
+    ///
+    /// Meant to be used only by `MessageView` implementations.
+    #[doc(hidden)]
+    fn merge_field(
+        &mut self,
+        tag: u32,
+        wire_type: WireType,
+        buf: &mut &'a [u8],
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError>;
+
+    /// Decodes a view of the message from a buffer.
+    ///
+    /// The entire buffer will be consumed.
+    fn decode(buf: &'a [u8]) -> Result<Self, DecodeError> {
+        let mut view = Self::default();
+        view.merge(buf).map(|_| view)
+    }
+
+    /// Decodes a view of a length-delimited message from the buffer.
+    fn decode_length_delimited(buf: &'a [u8]) -> Result<Self, DecodeError> {
+        let mut view = Self::default();
+        view.merge_length_delimited(buf)?;
+        Ok(view)
+    }
+
+    /// Decodes a view of the message from a buffer, and merges it into `self`.
+    ///
+    /// The entire buffer will be consumed.
+    fn merge(&mut self, mut buf: &'a [u8]) -> Result<(), DecodeError> {
+        let ctx = DecodeContext::default();
+        while !buf.is_empty() {
+            let (tag, wire_type) = decode_key(&mut buf)?;
+            self.merge_field(tag, wire_type, &mut buf, ctx.clone())?;
+        }
+        Ok(())
+    }
+
+    /// Decodes a view of a length-delimited message from buffer, and merges it into `self`.
+    fn merge_length_delimited(&mut self, mut buf: &'a [u8]) -> Result<(), DecodeError> {
+        message_view::merge(
+            WireType::LengthDelimited,
+            self,
+            &mut buf,
+            DecodeContext::default(),
+        )
+    }
+}
+
+impl<'a, M> MessageView<'a> for Box<M>
+where
+    M: MessageView<'a>,
+{
+    fn merge_field(
+        &mut self,
+        tag: u32,
+        wire_type: WireType,
+        buf: &mut &'a [u8],
+        ctx: DecodeContext,
+    ) -> Result<(), DecodeError> {
+        (**self).merge_field(tag, wire_type, buf, ctx)
+    }
+}
@@ -4,7 +4,7 @@ use std::io::Read;
 use std::path::Path;
 
 use criterion::{criterion_group, criterion_main, Criterion};
-use prost::Message;
+use prost::{Message, ReverseBuf};
 
 use protobuf::benchmarks::{dataset, proto2, proto3, BenchmarkDataset};
 
@@ -52,6 +52,25 @@ where
         });
     });
 
+    group.bench_function("encode_reverse", move |b| {
+        let messages = load_dataset(dataset)
+            .unwrap()
+            .payload
+            .iter()
+            .map(Vec::as_slice)
+            .map(M::decode)
+            .collect::<Result<Vec<_>, _>>()
+            .unwrap();
+        let mut buf = ReverseBuf::with_capacity(messages.iter().map(M::encoded_len).sum::<usize>());
+        b.iter(|| {
+            buf.clear();
+            for message in messages.iter().rev() {
+                message.encode_reverse(&mut buf);
+            }
+            criterion::black_box(&buf);
+        });
+    });
+
     group.bench_function("encoded_len", move |b| {
         let messages = load_dataset(dataset)
             .unwrap()
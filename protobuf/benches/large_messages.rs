@@ -0,0 +1,355 @@
+//! Benchmarks of large messages, shaped like production payloads rather than the Google
+//! benchmark datasets.
+//!
+//! Every benchmark reports its throughput in encoded bytes. The number of allocations made by one
+//! iteration of each benchmark is printed before it is measured.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::collections::{BTreeMap, HashMap};
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use prost::bytes::Bytes;
+use prost::{Message, Name};
+use prost_types::Any;
+
+/// Counts the allocations of the benchmarks.
+struct CountingAllocator;
+
+static ALLOCATIONS: AtomicUsize = AtomicUsize::new(0);
+
+unsafe impl GlobalAlloc for CountingAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        System.alloc(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout)
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        System.realloc(ptr, layout, new_size)
+    }
+}
+
+#[global_allocator]
+static ALLOCATOR: CountingAllocator = CountingAllocator;
+
+/// Prints the number of allocations made by one call to `f`.
+fn report_allocations<R>(group: &str, name: &str, f: impl FnOnce() -> R) {
+    let before = ALLOCATIONS.load(Ordering::Relaxed);
+    criterion::black_box(f());
+    let allocations = ALLOCATIONS.load(Ordering::Relaxed) - before;
+    println!("{}/{}: {} allocations", group, name, allocations);
+}
+
+/// A pseudo-random number generator, so that the messages are the same in every run.
+struct Rng(u64);
+
+impl Rng {
+    fn next(&mut self) -> u64 {
+        // xorshift64*
+        self.0 ^= self.0 >> 12;
+        self.0 ^= self.0 << 25;
+        self.0 ^= self.0 >> 27;
+        self.0.wrapping_mul(0x2545_f491_4f6c_dd1d)
+    }
+
+    /// Returns a value with a random number of significant bits, so that varints of all lengths
+    /// are encoded.
+    fn next_varint(&mut self) -> u64 {
+        let bits = self.next() % 64;
+        self.next() >> bits
+    }
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Tree {
+    #[prost(string, tag = "1")]
+    pub name: String,
+    #[prost(int64, tag = "2")]
+    pub value: i64,
+    #[prost(message, repeated, tag = "3")]
+    pub children: Vec<Tree>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Chain {
+    #[prost(bytes = "vec", tag = "1")]
+    pub payload: Vec<u8>,
+    #[prost(message, optional, boxed, tag = "2")]
+    pub next: Option<Box<Chain>>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Packed {
+    #[prost(uint64, repeated, tag = "1")]
+    pub varints: Vec<u64>,
+    #[prost(sint32, repeated, tag = "2")]
+    pub zigzags: Vec<i32>,
+    #[prost(fixed32, repeated, tag = "3")]
+    pub fixed: Vec<u32>,
+    #[prost(double, repeated, tag = "4")]
+    pub doubles: Vec<f64>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Labels {
+    #[prost(map = "string, string", tag = "1")]
+    pub labels: HashMap<String, String>,
+    #[prost(btree_map = "uint64, message", tag = "2")]
+    pub events: BTreeMap<u64, Event>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Blobs {
+    #[prost(bytes = "vec", repeated, tag = "1")]
+    pub blobs: Vec<Vec<u8>>,
+}
+
+/// `Blobs`, with blobs which are decoded without copying from a `Bytes` buffer.
+#[derive(Clone, PartialEq, Message)]
+pub struct SharedBlobs {
+    #[prost(bytes = "bytes", repeated, tag = "1")]
+    pub blobs: Vec<Bytes>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Event {
+    #[prost(uint64, tag = "1")]
+    pub id: u64,
+    #[prost(string, tag = "2")]
+    pub kind: String,
+    #[prost(fixed64, tag = "3")]
+    pub timestamp: u64,
+    #[prost(sint64, tag = "4")]
+    pub delta: i64,
+}
+
+impl Name for Event {
+    const NAME: &'static str = "Event";
+    const PACKAGE: &'static str = "benchmarks";
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Envelope {
+    #[prost(message, repeated, tag = "1")]
+    pub payloads: Vec<Any>,
+}
+
+fn tree(rng: &mut Rng, depth: u32, fan_out: usize) -> Tree {
+    Tree {
+        name: format!("node {}", rng.next() % 1000),
+        value: rng.next_varint() as i64,
+        children: if depth == 0 {
+            Vec::new()
+        } else {
+            (0..fan_out)
+                .map(|_| tree(rng, depth - 1, fan_out))
+                .collect()
+        },
+    }
+}
+
+fn chain(depth: u32) -> Chain {
+    (0..depth).fold(Chain::default(), |next, depth| Chain {
+        payload: vec![depth as u8; 64],
+        next: Some(Box::new(next)),
+    })
+}
+
+fn packed(rng: &mut Rng, len: usize) -> Packed {
+    Packed {
+        varints: (0..len).map(|_| rng.next_varint()).collect(),
+        zigzags: (0..len).map(|_| rng.next_varint() as i32).collect(),
+        fixed: (0..len).map(|_| rng.next() as u32).collect(),
+        doubles: (0..len).map(|_| rng.next() as f64).collect(),
+    }
+}
+
+fn event(rng: &mut Rng) -> Event {
+    Event {
+        id: rng.next_varint(),
+        kind: ["click", "view", "purchase", "scroll"][rng.next() as usize % 4].to_string(),
+        timestamp: rng.next(),
+        delta: rng.next_varint() as i64,
+    }
+}
+
+fn labels(rng: &mut Rng, len: usize) -> Labels {
+    Labels {
+        labels: (0..len)
+            .map(|i| (format!("label {}", i), format!("value {}", rng.next())))
+            .collect(),
+        events: (0..len).map(|_| (rng.next(), event(rng))).collect(),
+    }
+}
+
+fn blobs(rng: &mut Rng, count: usize, len: usize) -> Blobs {
+    Blobs {
+        blobs: (0..count)
+            .map(|_| (0..len).map(|_| rng.next() as u8).collect())
+            .collect(),
+    }
+}
+
+/// Benchmarks decoding, encoding and computing the encoded length of a message.
+fn benchmark_message<M>(criterion: &mut Criterion, name: &str, message: M)
+where
+    M: Message + Default,
+{
+    let name = format!("large_messages/{}", name);
+    let encoded = message.encode_to_vec();
+    let mut group = criterion.benchmark_group(&name);
+    group.throughput(Throughput::Bytes(encoded.len() as u64));
+
+    report_allocations(&name, "decode", || M::decode(encoded.as_slice()).unwrap());
+    group.bench_function("decode", |b| {
+        b.iter(|| M::decode(criterion::black_box(encoded.as_slice())).unwrap())
+    });
+
+    let mut buf = Vec::with_capacity(encoded.len());
+    report_allocations(&name, "encode", || message.encode(&mut buf).unwrap());
+    group.bench_function("encode", |b| {
+        b.iter(|| {
+            buf.clear();
+            message.encode(&mut buf).unwrap();
+            criterion::black_box(&buf);
+        })
+    });
+
+    group.bench_function("encoded_len", |b| {
+        b.iter(|| criterion::black_box(&message).encoded_len())
+    });
+    group.finish();
+}
+
+fn nested(criterion: &mut Criterion) {
+    let mut rng = Rng(1);
+    benchmark_message(criterion, "wide_tree", tree(&mut rng, 3, 32));
+    benchmark_message(criterion, "deep_tree", tree(&mut rng, 12, 2));
+    benchmark_message(criterion, "chain", chain(90));
+}
+
+fn packed_arrays(criterion: &mut Criterion) {
+    let mut rng = Rng(2);
+    benchmark_message(criterion, "packed", packed(&mut rng, 256 * 1024));
+}
+
+fn maps(criterion: &mut Criterion) {
+    let mut rng = Rng(3);
+    benchmark_message(criterion, "maps", labels(&mut rng, 16 * 1024));
+}
+
+fn bytes_blobs(criterion: &mut Criterion) {
+    let mut rng = Rng(4);
+    let blobs = blobs(&mut rng, 16, 256 * 1024);
+    let shared = SharedBlobs {
+        blobs: blobs.blobs.iter().cloned().map(Bytes::from).collect(),
+    };
+    benchmark_message(criterion, "blobs_vec", blobs);
+    benchmark_message(criterion, "blobs_bytes", shared.clone());
+
+    // Decoding from a `Bytes` buffer shares it with the decoded fields instead of copying them.
+    let name = "large_messages/blobs_bytes";
+    let encoded = Bytes::from(shared.encode_to_vec());
+    let mut group = criterion.benchmark_group(name);
+    group.throughput(Throughput::Bytes(encoded.len() as u64));
+    report_allocations(name, "decode_from_bytes", || {
+        SharedBlobs::decode(encoded.clone()).unwrap()
+    });
+    group.bench_function("decode_from_bytes", |b| {
+        b.iter(|| SharedBlobs::decode(criterion::black_box(encoded.clone())).unwrap())
+    });
+    group.finish();
+}
+
+fn stream(criterion: &mut Criterion) {
+    let mut rng = Rng(5);
+    let events = (0..100_000).map(|_| event(&mut rng)).collect::<Vec<_>>();
+    let encoded = prost::encode_batch_length_delimited_to_vec(&events);
+
+    let name = "large_messages/stream";
+    let mut group = criterion.benchmark_group(name);
+    group.throughput(Throughput::Bytes(encoded.len() as u64));
+
+    let decode = || {
+        let mut buf = encoded.as_slice();
+        let mut events = Vec::new();
+        while !buf.is_empty() {
+            events.push(Event::decode_length_delimited(&mut buf).unwrap());
+        }
+        events
+    };
+    report_allocations(name, "decode", decode);
+    group.bench_function("decode", |b| b.iter(decode));
+
+    let mut buf = Vec::with_capacity(encoded.len());
+    let encode = |buf: &mut Vec<u8>| {
+        buf.clear();
+        for event in &events {
+            event.encode_length_delimited(buf).unwrap();
+        }
+    };
+    report_allocations(name, "encode", || encode(&mut buf));
+    group.bench_function("encode", |b| b.iter(|| encode(&mut buf)));
+
+    let encode_batch = |buf: &mut Vec<u8>| {
+        buf.clear();
+        prost::encode_batch_length_delimited(&events, buf).unwrap();
+    };
+    report_allocations(name, "encode_batch", || encode_batch(&mut buf));
+    group.bench_function("encode_batch", |b| b.iter(|| encode_batch(&mut buf)));
+    group.finish();
+}
+
+fn any(criterion: &mut Criterion) {
+    let mut rng = Rng(6);
+    let events = (0..10_000).map(|_| event(&mut rng)).collect::<Vec<_>>();
+    let envelope = Envelope {
+        payloads: events
+            .iter()
+            .map(|event| Any::from_msg(event).unwrap())
+            .collect(),
+    };
+
+    let name = "large_messages/any";
+    let mut group = criterion.benchmark_group(name);
+    group.throughput(Throughput::Bytes(envelope.encoded_len() as u64));
+
+    let pack = || {
+        events
+            .iter()
+            .map(|event| Any::from_msg(event).unwrap())
+            .collect::<Vec<_>>()
+    };
+    report_allocations(name, "pack", pack);
+    group.bench_function("pack", |b| b.iter(pack));
+
+    let unpack = || {
+        envelope
+            .payloads
+            .iter()
+            .map(|any| any.to_msg::<Event>().unwrap())
+            .collect::<Vec<_>>()
+    };
+    report_allocations(name, "unpack", unpack);
+    group.bench_function("unpack", |b| b.iter(unpack));
+    group.finish();
+
+    benchmark_message(criterion, "any", envelope);
+}
+
+criterion_group!(
+    large_messages,
+    nested,
+    packed_arrays,
+    maps,
+    bytes_blobs,
+    stream,
+    any
+);
+
+criterion_main!(large_messages);
@@ -0,0 +1,142 @@
+use prost::alloc::vec;
+#[cfg(not(feature = "std"))]
+use prost::alloc::{boxed::Box, format, string::String, vec::Vec};
+
+use prost::{
+    encode_batch_length_delimited, encode_batch_length_delimited_iter,
+    encode_batch_length_delimited_to_vec, Message,
+};
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Record {
+    #[prost(uint64, tag = "1")]
+    pub id: u64,
+    #[prost(string, tag = "2")]
+    pub name: String,
+    #[prost(message, optional, tag = "3")]
+    pub parent: Option<Box<Record>>,
+}
+
+fn records(len: u64) -> Vec<Record> {
+    (0..len)
+        .map(|id| Record {
+            id,
+            name: "x".repeat(id as usize % 200),
+            parent: (id % 3 == 0).then(|| {
+                Box::new(Record {
+                    id,
+                    name: format!("parent of {}", id),
+                    parent: None,
+                })
+            }),
+        })
+        .collect()
+}
+
+/// Encodes the records one at a time.
+fn encode_each(records: &[Record]) -> Vec<u8> {
+    let mut buf = Vec::new();
+    for record in records {
+        record.encode_length_delimited(&mut buf).unwrap();
+    }
+    buf
+}
+
+/// Decodes a stream of length-delimited records.
+fn decode_all(mut buf: &[u8]) -> Vec<Record> {
+    let mut records = Vec::new();
+    while !buf.is_empty() {
+        records.push(Record::decode_length_delimited(&mut buf).unwrap());
+    }
+    records
+}
+
+#[test]
+fn encode_batch_matches_encode_each() {
+    for len in [0, 1, 2, 1000] {
+        let records = records(len);
+        let expected = encode_each(&records);
+
+        let mut buf = Vec::new();
+        encode_batch_length_delimited(&records, &mut buf).unwrap();
+        assert_eq!(buf, expected);
+
+        let mut buf = Vec::new();
+        encode_batch_length_delimited_iter(&records, &mut buf).unwrap();
+        assert_eq!(buf, expected);
+
+        let buf = encode_batch_length_delimited_to_vec(&records);
+        assert_eq!(buf, expected);
+
+        assert_eq!(decode_all(&buf), records);
+    }
+}
+
+#[test]
+fn encode_batch_iter_filtered() {
+    let records = records(100);
+    let even = records
+        .iter()
+        .filter(|record| record.id % 2 == 0)
+        .cloned()
+        .collect::<Vec<_>>();
+
+    let mut buf = Vec::new();
+    encode_batch_length_delimited_iter(
+        records.iter().filter(|record| record.id % 2 == 0),
+        &mut buf,
+    )
+    .unwrap();
+    assert_eq!(buf, encode_each(&even));
+}
+
+#[test]
+fn encode_batch_appends() {
+    let records = records(10);
+    let mut buf = vec![0xff; 3];
+    encode_batch_length_delimited(&records, &mut buf).unwrap();
+    assert_eq!(&buf[..3], [0xff; 3]);
+    assert_eq!(&buf[3..], encode_each(&records));
+}
+
+#[test]
+fn encode_batch_insufficient_capacity() {
+    let records = records(10);
+    let len = encode_each(&records).len();
+
+    let mut storage = vec![0; len - 1];
+    let mut buf = &mut storage[..];
+    let error = encode_batch_length_delimited(&records, &mut buf).unwrap_err();
+    assert_eq!(error.required_capacity(), len);
+    assert_eq!(error.remaining(), len - 1);
+    // Nothing is written.
+    assert_eq!(buf.len(), len - 1);
+    assert!(storage.iter().all(|&byte| byte == 0));
+
+    let mut storage = vec![0; len];
+    let mut buf = &mut storage[..];
+    encode_batch_length_delimited(&records, &mut buf).unwrap();
+    assert!(buf.is_empty());
+    assert_eq!(storage, encode_each(&records));
+}
+
+#[cfg(feature = "std")]
+#[test]
+fn encode_batch_parallel() {
+    use prost::encode_batch_length_delimited_parallel;
+
+    for len in [0, 1, 100_000] {
+        let records = records(len);
+        let mut buf = Vec::new();
+        encode_batch_length_delimited_parallel(&records, &mut buf).unwrap();
+        assert_eq!(buf, encode_each(&records));
+    }
+
+    let records = records(100_000);
+    let len = encode_each(&records).len();
+    let mut storage = vec![0; len - 1];
+    let mut buf = &mut storage[..];
+    let error = encode_batch_length_delimited_parallel(&records, &mut buf).unwrap_err();
+    assert_eq!(error.required_capacity(), len);
+    assert!(storage.iter().all(|&byte| byte == 0));
+}
@@ -171,6 +171,54 @@ fn main() {
         .compile_protos(&[src.join("type_names.proto")], includes)
         .unwrap();
 
+    prost_build::Config::new()
+        .protoc_arg("--experimental_allow_proto3_optional")
+        .message_view([".message_view.Envelope", ".message_view.Header"])
+        .compile_protos(&[src.join("message_view.proto")], includes)
+        .unwrap();
+
+    prost_build::Config::new()
+        .btree_map([".intern.Point.units"])
+        .intern_strings([".intern.Point", ".intern.Batch.latest"])
+        .compile_protos(&[src.join("intern.proto")], includes)
+        .unwrap();
+
+    prost_build::Config::new()
+        .lazy([".lazy.Envelope"])
+        .compile_protos(&[src.join("lazy.proto")], includes)
+        .unwrap();
+
+    prost_build::Config::new()
+        .btree_map([".map_hasher.Labels.ordered"])
+        .map_hasher(
+            [".map_hasher"],
+            "::std::hash::BuildHasherDefault<::std::collections::hash_map::DefaultHasher>",
+        )
+        .compile_protos(&[src.join("map_hasher.proto")], includes)
+        .unwrap();
+
+    prost_build::Config::new()
+        .btree_map(["."])
+        .compile_protos(&[src.join("projection.proto")], includes)
+        .unwrap();
+
+    prost_build::Config::new()
+        .btree_map(["."])
+        .string_type([".string_type"], "::prost::alloc::sync::Arc<str>")
+        .compile_protos(&[src.join("string_type.proto")], includes)
+        .unwrap();
+
+    prost_build::Config::new()
+        .preserve_unknown_fields([".unknown_fields.Legacy"])
+        .compile_protos(&[src.join("unknown_fields.proto")], includes)
+        .unwrap();
+
+    prost_build::Config::new()
+        .bytes([".dyn_buf"])
+        .dyn_buf([".dyn_buf.Leaf", ".dyn_buf.Node"])
+        .compile_protos(&[src.join("dyn_buf.proto")], includes)
+        .unwrap();
+
     // Check that attempting to compile a .proto without a package declaration does not result in an error.
     config
         .compile_protos(&[src.join("no_package.proto")], includes)
@@ -0,0 +1,268 @@
+use std::collections::HashMap;
+
+use prost::bytes::{Buf, Bytes};
+use prost::{DecodeOptions, Message};
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Record {
+    #[prost(string, tag = "1")]
+    pub name: String,
+    #[prost(bytes = "vec", tag = "2")]
+    pub payload: Vec<u8>,
+    #[prost(uint64, repeated, tag = "3")]
+    pub ids: Vec<u64>,
+    #[prost(fixed32, repeated, tag = "4")]
+    pub values: Vec<u32>,
+    #[prost(message, repeated, tag = "5")]
+    pub children: Vec<Record>,
+    #[prost(map = "string, uint32", tag = "6")]
+    pub labels: HashMap<String, u32>,
+    #[prost(string, repeated, tag = "7")]
+    pub tags: Vec<String>,
+}
+
+fn record() -> Record {
+    Record {
+        name: "record".to_string(),
+        payload: vec![7; 100],
+        ids: (0..50).map(|id| id << 20).collect(),
+        values: (0..50).collect(),
+        children: vec![Record::default(); 3],
+        labels: [("a".to_string(), 1), ("b".to_string(), 2)].into(),
+        tags: vec!["x".to_string(); 4],
+    }
+}
+
+fn error(encoded: impl Buf, options: DecodeOptions) -> String {
+    Record::decode_with_options(encoded, &options)
+        .unwrap_err()
+        .to_string()
+}
+
+#[test]
+fn decode_with_default_options() {
+    let record = record();
+    let encoded = record.encode_to_vec();
+    assert_eq!(
+        Record::decode_with_options(encoded.as_slice(), &DecodeOptions::default()),
+        Ok(record)
+    );
+}
+
+#[test]
+fn max_message_size() {
+    let encoded = record().encode_to_vec();
+    let options = DecodeOptions::new().max_message_size(encoded.len());
+    assert!(Record::decode_with_options(encoded.as_slice(), &options).is_ok());
+    assert_eq!(
+        error(
+            encoded.as_slice(),
+            options.max_message_size(encoded.len() - 1)
+        ),
+        "failed to decode Protobuf message: message size limit exceeded"
+    );
+}
+
+#[test]
+fn recursion_limit() {
+    let mut record = Record::default();
+    for _ in 0..10 {
+        record = Record {
+            children: vec![record],
+            ..Record::default()
+        };
+    }
+    let encoded = record.encode_to_vec();
+
+    let options = DecodeOptions::new().recursion_limit(10);
+    assert_eq!(
+        Record::decode_with_options(encoded.as_slice(), &options),
+        Ok(record)
+    );
+    assert!(error(encoded.as_slice(), options.recursion_limit(9))
+        .ends_with("Record.children: recursion limit reached"));
+}
+
+#[test]
+fn max_repeated_len() {
+    let encoded = record().encode_to_vec();
+    let options = DecodeOptions::new().max_repeated_len(50);
+    assert!(Record::decode_with_options(encoded.as_slice(), &options).is_ok());
+
+    // The packed varints are counted exactly, in a contiguous buffer or not.
+    let options = options.max_repeated_len(49);
+    let expected =
+        "failed to decode Protobuf message: Record.ids: repeated field length limit exceeded";
+    assert_eq!(error(encoded.as_slice(), options), expected);
+    let (front, back) = encoded.split_at(encoded.len() / 2);
+    assert_eq!(error(front.chain(back), options), expected);
+
+    let records = [
+        (
+            "children",
+            Record {
+                children: vec![Record::default(); 3],
+                ..Record::default()
+            },
+        ),
+        (
+            "labels",
+            Record {
+                labels: [("a".to_string(), 1), ("b".to_string(), 2)].into(),
+                ..Record::default()
+            },
+        ),
+        (
+            "tags",
+            Record {
+                tags: vec!["x".to_string(); 4],
+                ..Record::default()
+            },
+        ),
+    ];
+    for (field, record) in records {
+        let len = record.children.len() + record.labels.len() + record.tags.len();
+        let encoded = record.encode_to_vec();
+        let options = DecodeOptions::new().max_repeated_len(len);
+        assert!(Record::decode_with_options(encoded.as_slice(), &options).is_ok());
+        assert_eq!(
+            error(encoded.as_slice(), options.max_repeated_len(len - 1)),
+            format!(
+                "failed to decode Protobuf message: Record.{}: repeated field length limit exceeded",
+                field
+            )
+        );
+    }
+}
+
+#[test]
+fn max_allocation() {
+    let record = Record {
+        payload: vec![0; 1000],
+        ..Record::default()
+    };
+    let encoded = Bytes::from(record.encode_to_vec());
+    let options = DecodeOptions::new().max_allocation(1000);
+    assert!(Record::decode_with_options(encoded.clone(), &options).is_ok());
+    assert_eq!(
+        error(encoded, options.max_allocation(999)),
+        "failed to decode Protobuf message: Record.payload: allocation limit exceeded"
+    );
+
+    // Repeated elements are counted with their in-memory size.
+    let record = Record {
+        ids: vec![1; 100],
+        ..Record::default()
+    };
+    let encoded = record.encode_to_vec();
+    assert!(encoded.len() < 110);
+    let options = DecodeOptions::new().max_allocation(800);
+    assert!(Record::decode_with_options(encoded.as_slice(), &options).is_ok());
+    assert_eq!(
+        error(encoded.as_slice(), options.max_allocation(799)),
+        "failed to decode Protobuf message: Record.ids: allocation limit exceeded"
+    );
+
+    // The budget is shared by all fields of all nested messages.
+    let record = Record {
+        name: "a".repeat(10),
+        children: vec![
+            Record {
+                name: "b".repeat(10),
+                ..Record::default()
+            };
+            2
+        ],
+        ..Record::default()
+    };
+    let encoded = record.encode_to_vec();
+    let size = 30 + 2 * std::mem::size_of::<Record>();
+    let options = DecodeOptions::new().max_allocation(size);
+    assert!(Record::decode_with_options(encoded.as_slice(), &options).is_ok());
+    assert!(
+        Record::decode_with_options(encoded.as_slice(), &options.max_allocation(size - 1)).is_err()
+    );
+}
+
+#[test]
+fn max_allocation_reserved() {
+    // The capacity reserved for a run of repeated messages or map entries is charged when it is
+    // reserved, and not again for the elements decoded into it.
+    let record = Record {
+        children: vec![Record::default(); 100],
+        ..Record::default()
+    };
+    let encoded = record.encode_to_vec();
+    let size = 100 * std::mem::size_of::<Record>();
+    let options = DecodeOptions::new().max_allocation(size);
+    let decoded = Record::decode_with_options(encoded.as_slice(), &options).unwrap();
+    assert_eq!(decoded.children.capacity(), 100);
+    assert_eq!(
+        error(encoded.as_slice(), options.max_allocation(size - 1)),
+        "failed to decode Protobuf message: Record.children: allocation limit exceeded"
+    );
+
+    let record = Record {
+        labels: (0..100).map(|i| (i.to_string(), i)).collect(),
+        ..Record::default()
+    };
+    let encoded = record.encode_to_vec();
+    let size = 100 * std::mem::size_of::<(String, u32)>()
+        + record.labels.keys().map(String::len).sum::<usize>();
+    let options = DecodeOptions::new().max_allocation(size);
+    assert!(Record::decode_with_options(encoded.as_slice(), &options).is_ok());
+    assert!(
+        Record::decode_with_options(encoded.as_slice(), &options.max_allocation(size - 1)).is_err()
+    );
+}
+
+#[test]
+fn max_allocation_unknown_fields() {
+    use crate::unknown_fields::{Current, Legacy};
+
+    // Preserved unknown fields are counted, even when they are not copied.
+    let current = Current {
+        data: Some(vec![7; 1000]),
+        ..Current::default()
+    };
+    let encoded = Bytes::from(current.encode_to_vec());
+    let options = DecodeOptions::new().max_allocation(2000);
+    assert!(Legacy::decode_with_options(encoded.clone(), &options).is_ok());
+    let options = options.max_allocation(1000);
+    assert!(Legacy::decode_with_options(encoded.clone(), &options).is_err());
+    let (front, back) = encoded.split_at(500);
+    assert!(Legacy::decode_with_options(front.chain(back), &options).is_err());
+}
+
+#[test]
+fn max_allocation_lazy() {
+    use crate::lazy::{Envelope, Payload};
+
+    // The encoded bytes kept by a lazy field are counted, even when they are not copied.
+    let envelope = Envelope {
+        required_payload: Payload {
+            data: Some("a".repeat(1000)),
+            ..Payload::default()
+        }
+        .into(),
+        ..Envelope::default()
+    };
+    let encoded = Bytes::from(envelope.encode_to_vec());
+    let options = DecodeOptions::new().max_allocation(1003);
+    assert!(Envelope::decode_with_options(encoded.clone(), &options).is_ok());
+    let options = options.max_allocation(1002);
+    assert_eq!(
+        Envelope::decode_with_options(encoded, &options)
+            .unwrap_err()
+            .to_string(),
+        "failed to decode Protobuf message: Envelope.required_payload: allocation limit exceeded"
+    );
+}
+
+#[test]
+fn limits_are_restored() {
+    let encoded = record().encode_to_vec();
+    let options = DecodeOptions::new().max_allocation(0);
+    assert!(Record::decode_with_options(encoded.as_slice(), &options).is_err());
+    assert!(Record::decode(encoded.as_slice()).is_ok());
+}
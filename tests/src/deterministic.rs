@@ -0,0 +1,82 @@
+use std::collections::{BTreeMap, HashMap};
+
+use prost::Message;
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Index {
+    #[prost(map = "string, message", tag = "1")]
+    pub entries: HashMap<String, Entry>,
+    #[prost(map = "sint32, string", tag = "2")]
+    pub names: HashMap<i32, String>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Entry {
+    #[prost(map = "string, uint64", tag = "1")]
+    pub counts: HashMap<String, u64>,
+}
+
+/// `Index`, with maps which are always encoded in key order.
+#[derive(Clone, PartialEq, Message)]
+pub struct SortedIndex {
+    #[prost(btree_map = "string, message", tag = "1")]
+    pub entries: BTreeMap<String, SortedEntry>,
+    #[prost(btree_map = "sint32, string", tag = "2")]
+    pub names: BTreeMap<i32, String>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct SortedEntry {
+    #[prost(btree_map = "string, uint64", tag = "1")]
+    pub counts: BTreeMap<String, u64>,
+}
+
+fn counts(entry: usize) -> impl Iterator<Item = (String, u64)> {
+    (0..entry).map(|i| (format!("count{}", i), i as u64))
+}
+
+fn index(order: impl Iterator<Item = usize> + Clone) -> Index {
+    Index {
+        entries: order
+            .clone()
+            .map(|i| {
+                let entry = Entry {
+                    counts: counts(i).collect(),
+                };
+                (format!("entry{}", i), entry)
+            })
+            .collect(),
+        names: order
+            .map(|i| (i as i32 - 10, format!("name{}", i)))
+            .collect(),
+    }
+}
+
+#[test]
+fn encode_deterministic_sorts_maps() {
+    let forward = index(0..20);
+    let backward = index((0..20).rev());
+    assert_eq!(forward, backward);
+
+    let sorted = SortedIndex {
+        entries: (0..20)
+            .map(|i| {
+                let entry = SortedEntry {
+                    counts: counts(i).collect(),
+                };
+                (format!("entry{}", i), entry)
+            })
+            .collect(),
+        names: (0..20)
+            .map(|i| (i as i32 - 10, format!("name{}", i)))
+            .collect(),
+    };
+    let expected = sorted.encode_to_vec();
+
+    for index in [forward, backward] {
+        let mut buf = Vec::new();
+        index.encode_deterministic(&mut buf).unwrap();
+        assert_eq!(buf, expected);
+        assert_eq!(Index::decode(&*buf).unwrap(), index);
+    }
+}
@@ -0,0 +1,140 @@
+use prost::alloc::vec;
+#[cfg(not(feature = "std"))]
+use prost::alloc::{borrow::ToOwned, boxed::Box, format, string::String};
+
+use prost::bytes::{Buf, Bytes, BytesMut};
+use prost::{Message, VectoredBuf};
+
+include!(concat!(env!("OUT_DIR"), "/dyn_buf.rs"));
+
+/// `Leaf`, with generic methods.
+#[derive(Clone, PartialEq, Message)]
+pub struct GenericLeaf {
+    #[prost(int32, tag = "1")]
+    pub id: i32,
+    #[prost(string, tag = "2")]
+    pub name: String,
+}
+
+fn leaf(id: i32) -> Leaf {
+    Leaf {
+        id,
+        name: format!("leaf {}", id),
+    }
+}
+
+fn node() -> Node {
+    Node {
+        id: -7,
+        name: "root".to_owned(),
+        payload: Bytes::from(vec![1; 100]),
+        values: vec![1, 300, 70000],
+        weights: vec![0.5, -1.25],
+        leaf: Some(leaf(1)),
+        children: vec![
+            Node::default(),
+            Node {
+                name: "child".to_owned(),
+                leaves: [("a".to_owned(), leaf(2))].into_iter().collect(),
+                ..Node::default()
+            },
+        ],
+        leaves: [("b".to_owned(), leaf(3)), ("c".to_owned(), leaf(4))]
+            .into_iter()
+            .collect(),
+        choice: Some(node::Choice::Node(Box::new(Node {
+            choice: Some(node::Choice::Text("text".to_owned())),
+            ..Node::default()
+        }))),
+        plain: Some(Plain {
+            name: "plain".to_owned(),
+            leaf: Some(leaf(5)),
+        }),
+    }
+}
+
+#[test]
+fn dyn_buf_encodes_like_generic() {
+    let generic = GenericLeaf {
+        id: 3,
+        name: "leaf 3".to_owned(),
+    };
+    assert_eq!(leaf(3).encode_to_vec(), generic.encode_to_vec());
+    assert_eq!(
+        Leaf::decode(generic.encode_to_vec().as_slice()).unwrap(),
+        leaf(3)
+    );
+
+    let node = node();
+    let encoded = node.encode_to_vec();
+    assert_eq!(encoded.len(), node.encoded_len());
+    let mut buf = BytesMut::new();
+    node.encode(&mut buf).unwrap();
+    assert_eq!(buf, encoded);
+}
+
+#[test]
+fn dyn_buf_decodes_from_any_buffer() {
+    let node = node();
+    let encoded = node.encode_to_vec();
+    assert_eq!(Node::decode(encoded.as_slice()).unwrap(), node);
+
+    // Bytes fields share the decoded buffer.
+    let encoded = Bytes::from(encoded);
+    let decoded = Node::decode(encoded.clone()).unwrap();
+    assert_eq!(decoded, node);
+    assert!(encoded.as_ptr_range().contains(&decoded.payload.as_ptr()));
+
+    for split in [1, encoded.len() / 2, encoded.len() - 1] {
+        let (front, back) = encoded.split_at(split);
+        assert_eq!(Node::decode(front.chain(back)).unwrap(), node);
+    }
+
+    let mut reused = node.clone();
+    reused.children.push(Node::default());
+    reused.decode_reusing(encoded.clone()).unwrap();
+    assert_eq!(reused, node);
+}
+
+#[test]
+fn dyn_buf_vectored_references_bytes() {
+    let payload = Bytes::from(vec![7; 100]);
+    let node = Node {
+        name: "root".to_owned(),
+        children: vec![Node {
+            payload: payload.clone(),
+            ..Node::default()
+        }],
+        ..Node::default()
+    };
+
+    let mut buf = VectoredBuf::with_min_segment_len(64);
+    node.encode(&mut buf).unwrap();
+    let segments = buf.into_segments();
+    assert!(segments
+        .iter()
+        .any(|segment| segment.as_ptr() == payload.as_ptr()));
+    assert_eq!(segments.concat(), node.encode_to_vec());
+}
+
+#[test]
+fn dyn_buf_recursion_limit() {
+    let mut node = Node::default();
+    for _ in 0..100 {
+        node = Node {
+            children: vec![node],
+            ..Node::default()
+        };
+    }
+    let encoded = node.encode_to_vec();
+    assert_eq!(Node::decode(encoded.as_slice()).unwrap(), node);
+
+    let node = Node {
+        children: vec![node],
+        ..Node::default()
+    };
+    assert!(Node::decode(node.encode_to_vec().as_slice())
+        .unwrap_err()
+        .to_string()
+        .ends_with("Node.children: recursion limit reached"));
+}
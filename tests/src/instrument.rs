@@ -0,0 +1,216 @@
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::cell::{Cell, RefCell};
+
+use prost::encoding::WireType;
+use prost::instrument::{self, Sink};
+use prost::Message;
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Outer {
+    #[prost(string, tag = "1")]
+    pub name: String,
+    #[prost(message, optional, tag = "2")]
+    pub inner: Option<Inner>,
+    #[prost(message, repeated, tag = "3")]
+    pub items: Vec<Inner>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Inner {
+    #[prost(uint32, tag = "1")]
+    pub value: u32,
+}
+
+/// `Outer`, with a field which `Outer` does not know about.
+#[derive(Clone, PartialEq, Message)]
+pub struct NewOuter {
+    #[prost(string, tag = "1")]
+    pub name: String,
+    #[prost(message, optional, tag = "2")]
+    pub inner: Option<Inner>,
+    #[prost(message, repeated, tag = "3")]
+    pub items: Vec<Inner>,
+    #[prost(fixed64, tag = "4")]
+    pub added: u64,
+}
+
+#[derive(Debug, PartialEq)]
+enum Event {
+    Decoded(&'static str, usize, u32, u64),
+    Encoded(&'static str, usize),
+    Skipped(&'static str, u32, WireType),
+    Unknown(&'static str, u32, WireType),
+}
+
+thread_local! {
+    /// The events reported on this thread, so that tests running in parallel do not see each
+    /// other's events.
+    static EVENTS: RefCell<Vec<Event>> = const { RefCell::new(Vec::new()) };
+    static ALLOCATIONS: Cell<u64> = const { Cell::new(0) };
+}
+
+/// Counts the allocations of each thread.
+struct CountingAllocator;
+
+unsafe impl GlobalAlloc for CountingAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        let _ = ALLOCATIONS.try_with(|count| count.set(count.get() + 1));
+        System.alloc(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout)
+    }
+}
+
+#[global_allocator]
+static ALLOCATOR: CountingAllocator = CountingAllocator;
+
+struct RecordingSink;
+
+impl RecordingSink {
+    fn record(&self, event: Event) {
+        EVENTS.with(|events| events.borrow_mut().push(event));
+    }
+}
+
+impl Sink for RecordingSink {
+    fn decoded(&self, message: &'static str, len: usize, depth: u32, allocations: u64) {
+        self.record(Event::Decoded(message, len, depth, allocations));
+    }
+
+    fn encoded(&self, message: &'static str, len: usize) {
+        self.record(Event::Encoded(message, len));
+    }
+
+    fn skipped_field(&self, message: &'static str, tag: u32, wire_type: WireType) {
+        self.record(Event::Skipped(message, tag, wire_type));
+    }
+
+    fn unknown_field(&self, message: &'static str, tag: u32, wire_type: WireType) {
+        self.record(Event::Unknown(message, tag, wire_type));
+    }
+
+    fn allocation_count(&self) -> u64 {
+        ALLOCATIONS.with(Cell::get)
+    }
+}
+
+static SINK: RecordingSink = RecordingSink;
+
+/// Returns the events reported on this thread while calling `f`.
+fn events(f: impl FnOnce()) -> Vec<Event> {
+    let _ = instrument::set_sink(&SINK);
+    // Recording an event must not allocate, or it would count as an allocation of the message
+    // being decoded.
+    EVENTS.with(|events| *events.borrow_mut() = Vec::with_capacity(16));
+    f();
+    EVENTS.with(|events| events.take())
+}
+
+fn outer() -> Outer {
+    Outer {
+        name: "outer".to_owned(),
+        inner: Some(Inner { value: 1 }),
+        items: vec![Inner { value: 300 }],
+    }
+}
+
+const OUTER: &str = "tests::instrument::Outer";
+const INNER: &str = "tests::instrument::Inner";
+
+#[test]
+fn instrument_encode() {
+    let outer = outer();
+    let mut buf = Vec::with_capacity(outer.encoded_len());
+    let forward = events(|| outer.encode(&mut buf).unwrap());
+    assert_eq!(
+        forward,
+        [
+            Event::Encoded(INNER, 2),
+            Event::Encoded(INNER, 3),
+            Event::Encoded(OUTER, outer.encoded_len()),
+        ]
+    );
+
+    let mut reverse = prost::ReverseBuf::new();
+    // Encoding in reverse writes the fields from last to first.
+    assert_eq!(
+        events(|| outer.encode_reverse(&mut reverse)),
+        [
+            Event::Encoded(INNER, 3),
+            Event::Encoded(INNER, 2),
+            Event::Encoded(OUTER, outer.encoded_len()),
+        ]
+    );
+}
+
+#[test]
+fn instrument_decode() {
+    let outer = outer();
+    let encoded = outer.encode_to_vec();
+    let mut decoded = None;
+    let events = events(|| decoded = Some(Outer::decode(encoded.as_slice()).unwrap()));
+    assert_eq!(decoded, Some(outer));
+    // Decoding `Outer` allocates its name and its `items`.
+    assert_eq!(
+        events,
+        [
+            Event::Decoded(INNER, 2, 1, 0),
+            Event::Decoded(INNER, 3, 1, 0),
+            Event::Decoded(OUTER, encoded.len(), 0, 2),
+        ]
+    );
+}
+
+#[test]
+fn instrument_unknown_field() {
+    let encoded = NewOuter {
+        name: "new".to_owned(),
+        added: 7,
+        ..NewOuter::default()
+    }
+    .encode_to_vec();
+    let events = events(|| drop(Outer::decode(encoded.as_slice()).unwrap()));
+    assert_eq!(
+        events,
+        [
+            Event::Unknown(OUTER, 4, WireType::SixtyFourBit),
+            Event::Skipped(OUTER, 4, WireType::SixtyFourBit),
+            Event::Decoded(OUTER, encoded.len(), 0, 1),
+        ]
+    );
+}
+
+#[test]
+fn instrument_stream_decode() {
+    let outer = outer();
+    let mut encoded = Vec::new();
+    outer.encode_length_delimited(&mut encoded).unwrap();
+    let (front, back) = encoded.split_at(encoded.len() / 2);
+
+    let mut decoder = prost::StreamDecoder::<Outer>::new(1024);
+    let mut decoded = None;
+    let mut events = events(|| {
+        decoder.push(front);
+        assert!(decoder.next_message().unwrap().is_none());
+        decoder.push(back);
+        decoded = decoder.next_message().unwrap();
+    });
+    assert_eq!(decoded, Some(outer.clone()));
+    // The message is decoded in pieces, and reported once it is complete. The decoder's own
+    // buffering counts as allocations of the message.
+    let last = events.pop();
+    assert!(
+        matches!(last, Some(Event::Decoded(OUTER, len, 0, _)) if len == outer.encoded_len()),
+        "{:?}",
+        last
+    );
+    assert_eq!(
+        events,
+        [
+            Event::Decoded(INNER, 2, 1, 0),
+            Event::Decoded(INNER, 3, 1, 0),
+        ]
+    );
+}
@@ -0,0 +1,99 @@
+use prost::{Interned, Message, StringInterner};
+
+include!(concat!(env!("OUT_DIR"), "/intern.rs"));
+
+fn point(i: usize) -> Point {
+    let mut point = Point {
+        name: "requests".into(),
+        labels: [
+            ("host".into(), format!("host{}", i % 2).into()),
+            ("region".into(), "eu".into()),
+        ]
+        .into_iter()
+        .collect(),
+        tags: vec!["a".into(), "".into()],
+        host: Some("host".into()),
+        value: Some(point::Value::Text("text".into())),
+        ..Point::default()
+    };
+    point.insert_units("latency".to_string(), Unit::Seconds);
+    point
+}
+
+fn batch() -> Batch {
+    Batch {
+        points: (0..10).map(point).collect(),
+        latest: [("requests".into(), point(0))].into_iter().collect(),
+        source: "source".to_string(),
+    }
+}
+
+#[test]
+fn intern_roundtrip() {
+    let batch = batch();
+    let encoded = batch.encode_to_vec();
+    assert_eq!(encoded.len(), batch.encoded_len());
+    assert_eq!(Batch::decode(&*encoded).unwrap(), batch);
+
+    let point = &batch.points[1];
+    assert_eq!(point.labels.get("host").unwrap(), "host1");
+    assert_eq!(point.get_units("latency"), Some(Unit::Seconds));
+    assert_eq!(point.host(), "host");
+    assert!(format!("{:?}", point).contains("units: {\"latency\": Seconds}"));
+    assert!(format!("{:?}", batch).contains("latest: {\"requests\": Point {"));
+}
+
+#[test]
+fn intern_decoded_strings() {
+    let encoded = batch().encode_to_vec();
+    let mut interner = StringInterner::new();
+    let decoded = prost::with_interner(&mut interner, || Batch::decode(&*encoded).unwrap());
+    assert_eq!(decoded, batch());
+
+    // Equal strings of all fields and map entries share the same allocation.
+    let first = &decoded.points[0];
+    for point in &decoded.points[1..] {
+        assert!(Interned::ptr_eq(&first.name, &point.name));
+        assert!(Interned::ptr_eq(&first.tags[0], &point.tags[0]));
+        let (key, value) = point.labels.get_key_value("region").unwrap();
+        let (first_key, first_value) = first.labels.get_key_value("region").unwrap();
+        assert!(Interned::ptr_eq(key, first_key));
+        assert!(Interned::ptr_eq(value, first_value));
+    }
+    let (key, point) = decoded.latest.iter().next().unwrap();
+    assert!(Interned::ptr_eq(key, &first.name));
+    assert!(Interned::ptr_eq(
+        &point.labels["host"],
+        &first.labels["host"]
+    ));
+
+    // The distinct values are "requests", "host", "host0", "host1", "region", "eu", "latency",
+    // "a" and "text": empty strings are left as they are. Fields which are not matched by
+    // `intern_strings` are plain strings.
+    assert_eq!(interner.len(), 9);
+    let _: &String = &decoded.source;
+
+    // Strings which are no longer used are removed from the interner.
+    drop(decoded);
+    interner.remove_unused();
+    assert!(interner.is_empty());
+
+    // Strings decoded without an interner are equal, but not shared.
+    let decoded = Batch::decode(&*encoded).unwrap();
+    assert!(!Interned::ptr_eq(
+        &decoded.points[0].name,
+        &decoded.points[1].name
+    ));
+}
+
+#[test]
+fn intern_reuses_decoded_strings() {
+    let encoded = point(0).encode_to_vec();
+    let mut decoded = Point::decode(&*encoded).unwrap();
+    let name = decoded.name.clone();
+
+    // Merging the same value again keeps the existing string, even without an interner.
+    decoded.merge(&*encoded).unwrap();
+    assert!(Interned::ptr_eq(&decoded.name, &name));
+    assert_eq!(decoded.tags.len(), 4);
+}
@@ -0,0 +1,108 @@
+use prost::alloc::vec;
+#[cfg(not(feature = "std"))]
+use prost::alloc::{boxed::Box, string::ToString};
+
+use prost::bytes::Bytes;
+use prost::{Lazy, Message};
+
+include!(concat!(env!("OUT_DIR"), "/lazy.rs"));
+
+fn payload(data: &str) -> Payload {
+    Payload {
+        data: Some(data.to_string()),
+        values: vec![1, 2, 3],
+    }
+}
+
+fn envelope() -> Envelope {
+    Envelope {
+        route: Some("route".to_string()),
+        payload: Some(Lazy::new(payload("payload"))),
+        payloads: vec![Lazy::new(payload("a")), Lazy::new(Payload::default())],
+        required_payload: Lazy::new(payload("required")),
+        parent: Some(Lazy::new(Box::new(Envelope {
+            route: Some("parent".to_string()),
+            ..Default::default()
+        }))),
+    }
+}
+
+#[test]
+fn lazy_roundtrip() {
+    let envelope = envelope();
+    let encoded = Bytes::from(envelope.encode_to_vec());
+
+    let decoded = Envelope::decode(encoded.clone()).unwrap();
+    assert!(!decoded.payload.as_ref().unwrap().is_decoded());
+    assert!(!decoded.required_payload.is_decoded());
+    assert_eq!(decoded, envelope);
+
+    // Fields which were never decoded are encoded verbatim.
+    assert_eq!(decoded.encode_to_vec(), encoded);
+    assert_eq!(decoded.encoded_len(), encoded.len());
+}
+
+#[test]
+fn lazy_decode_on_access() {
+    let encoded = envelope().encode_to_vec();
+    let mut decoded = Envelope::decode(encoded.as_slice()).unwrap();
+
+    assert_eq!(decoded.payloads[0].decode().unwrap(), payload("a"));
+    assert!(!decoded.payloads[0].is_decoded());
+
+    let payload = decoded.payload.as_mut().unwrap().get_mut().unwrap();
+    assert_eq!(payload.data.as_deref(), Some("payload"));
+    payload.data = Some("changed".to_string());
+    assert!(decoded.payload.as_ref().unwrap().is_decoded());
+
+    let reencoded = Envelope::decode(decoded.encode_to_vec().as_slice()).unwrap();
+    let payload = reencoded.payload.unwrap().into_inner().unwrap();
+    assert_eq!(payload.data.as_deref(), Some("changed"));
+}
+
+#[test]
+fn lazy_merge() {
+    let mut encoded = envelope().encode_to_vec();
+    encoded.extend_from_within(..);
+
+    // Merging an encoded field twice concatenates it, and decodes as a merge.
+    let decoded = Envelope::decode(encoded.as_slice()).unwrap();
+    let payload = decoded.payload.as_ref().unwrap().decode().unwrap();
+    assert_eq!(payload.values, [1, 2, 3, 1, 2, 3]);
+    assert_eq!(decoded.payloads.len(), 4);
+}
+
+#[test]
+fn lazy_invalid() {
+    // The nested payload is truncated, which is only detected once it is decoded.
+    let mut decoded = Envelope::decode(&[0x12, 0x02, 0x0a, 0x05, 0x22, 0x00][..]).unwrap();
+    assert!(decoded.payload.as_mut().unwrap().get_mut().is_err());
+}
+
+#[cfg(feature = "std")]
+#[test]
+fn lazy_get() {
+    let encoded = Bytes::from(envelope().encode_to_vec());
+    let mut decoded = Envelope::decode(encoded.clone()).unwrap();
+
+    // The nested message is decoded once, through a shared reference.
+    let lazy = decoded.payload.as_ref().unwrap();
+    let message = lazy.get().unwrap();
+    assert_eq!(*message, payload("payload"));
+    assert!(lazy.is_decoded());
+    assert!(core::ptr::eq(message, lazy.get().unwrap()));
+
+    // It is encoded verbatim until it is accessed mutably.
+    assert!(lazy.encoded().is_some());
+    assert_eq!(decoded.encode_to_vec(), encoded);
+    let message = decoded.payload.as_mut().unwrap().get_mut().unwrap();
+    message.values.push(4);
+    assert!(decoded.payload.as_ref().unwrap().encoded().is_none());
+    let reencoded = Envelope::decode(decoded.encode_to_vec().as_slice()).unwrap();
+    let payload = reencoded.payload.unwrap().into_inner().unwrap();
+    assert_eq!(payload.values, [1, 2, 3, 4]);
+
+    let decoded = Envelope::decode(&[0x12, 0x02, 0x0a, 0x05, 0x22, 0x00][..]).unwrap();
+    assert!(decoded.payload.as_ref().unwrap().get().is_err());
+    assert!(!decoded.payload.as_ref().unwrap().is_decoded());
+}
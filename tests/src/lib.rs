@@ -29,31 +29,72 @@ pub mod no_root_packages;
 pub mod packages;
 pub mod unittest;
 
+#[cfg(test)]
+mod batch;
 #[cfg(test)]
 mod bootstrap;
 #[cfg(test)]
 mod debug;
 #[cfg(test)]
+#[cfg(feature = "std")]
+mod decode_options;
+#[cfg(test)]
+#[cfg(feature = "std")]
+mod deterministic;
+#[cfg(test)]
 mod deprecated_field;
 #[cfg(test)]
 mod derive_copy;
 #[cfg(test)]
+mod dyn_buf;
+#[cfg(test)]
 mod enum_keyword_variant;
 #[cfg(test)]
 mod generic_derive;
 #[cfg(test)]
+#[cfg(feature = "instrument")]
+mod instrument;
+#[cfg(test)]
+#[cfg(feature = "std")]
+mod intern;
+#[cfg(test)]
+mod lazy;
+#[cfg(test)]
+#[cfg(feature = "std")]
+mod map_hasher;
+#[cfg(test)]
 mod message_encoding;
 #[cfg(test)]
+mod message_view;
+#[cfg(test)]
 mod no_shadowed_types;
 #[cfg(test)]
 mod no_unused_results;
 #[cfg(test)]
 #[cfg(feature = "std")]
+mod parallel;
+#[cfg(test)]
+#[cfg(feature = "std")]
+mod projection;
+#[cfg(test)]
+mod reuse;
+#[cfg(test)]
+mod reverse;
+#[cfg(test)]
+#[cfg(feature = "std")]
 mod skip_debug;
 #[cfg(test)]
+mod stream;
+#[cfg(test)]
+mod string_type;
+#[cfg(test)]
 mod submessage_without_package;
 #[cfg(test)]
 mod type_names;
+#[cfg(test)]
+mod unknown_fields;
+#[cfg(test)]
+mod vectored;
 
 mod test_enum_named_option_value {
     include!(concat!(env!("OUT_DIR"), "/myenum.optionn.rs"));
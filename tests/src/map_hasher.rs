@@ -0,0 +1,79 @@
+use std::collections::hash_map::DefaultHasher;
+use std::collections::{BTreeMap, HashMap};
+use std::hash::BuildHasherDefault;
+
+use prost::Message;
+
+include!(concat!(env!("OUT_DIR"), "/map_hasher.rs"));
+
+type Hasher = BuildHasherDefault<DefaultHasher>;
+
+fn labels(count: usize) -> Labels {
+    let mut labels = Labels::default();
+    for i in 0..count {
+        labels
+            .labels
+            .insert(format!("key{}", i), format!("value{}", i));
+        labels.insert_levels(format!("level{}", i), Level::High);
+        labels.ordered.insert(format!("key{}", i), String::new());
+    }
+    labels.children.insert(
+        1,
+        Labels {
+            labels: [("child".to_string(), "value".to_string())]
+                .into_iter()
+                .collect(),
+            ..Labels::default()
+        },
+    );
+    labels
+}
+
+#[test]
+fn map_hasher_types() {
+    let labels = Labels::default();
+    let _: &HashMap<String, String, Hasher> = &labels.labels;
+    let _: &HashMap<i32, Labels, Hasher> = &labels.children;
+    let _: &HashMap<String, i32, Hasher> = &labels.levels;
+    let _: &BTreeMap<String, String> = &labels.ordered;
+}
+
+#[test]
+fn map_hasher_roundtrip() {
+    for count in [0, 1, 100] {
+        let labels = labels(count);
+        let decoded = Labels::decode(&labels.encode_to_vec()[..]).unwrap();
+        assert_eq!(decoded, labels);
+        assert_eq!(
+            decoded.get_levels("level0"),
+            (count > 0).then_some(Level::High)
+        );
+    }
+}
+
+#[test]
+fn map_hasher_reserves_entries() {
+    let labels = labels(100);
+    let decoded = Labels::decode(&labels.encode_to_vec()[..]).unwrap();
+    assert!(decoded.labels.capacity() >= 100);
+    // The debug output of the maps is unaffected by the hasher.
+    assert!(format!("{:?}", decoded).contains("\"key7\": \"value7\""));
+}
+
+#[test]
+fn map_hasher_reserves_entries_of_own_message() {
+    // The entries of the parent map which follow the nested map are not reserved for by it.
+    let mut child = Labels::default();
+    child.children.insert(1, Labels::default());
+    let mut parent = Labels::default();
+    parent.children.insert(1, child);
+    let mut encoded = parent.encode_to_vec();
+    for key in 2..1000 {
+        let mut sibling = Labels::default();
+        sibling.children.insert(key, Labels::default());
+        sibling.encode(&mut encoded).unwrap();
+    }
+    let decoded = Labels::decode(&encoded[..]).unwrap();
+    assert_eq!(decoded.children.len(), 999);
+    assert!(decoded.children[&1].children.capacity() < 16);
+}
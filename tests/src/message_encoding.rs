@@ -34,6 +34,30 @@ fn check_scalar_types() {
     check_message(&ScalarTypes::default());
 }
 
+#[test]
+fn check_fixed_width_scalar_types() {
+    // The encoded lengths of fixed-width fields are computed at compile time.
+    check_message(&ScalarTypes {
+        fixed32: 1,
+        fixed64: 2,
+        sfixed32: -3,
+        sfixed64: -4,
+        float: 5.0,
+        double: 6.0,
+        _bool: true,
+        optional_fixed32: Some(0),
+        optional_double: Some(1.0),
+        optional_bool: Some(false),
+        repeated_sfixed32: vec![1, 2, 3],
+        repeated_float: vec![0.5; 3],
+        repeated_bool: vec![true, false],
+        packed_fixed64: vec![1, 2, 3],
+        packed_double: vec![0.25; 200],
+        packed_bool: vec![true; 130],
+        ..ScalarTypes::default()
+    });
+}
+
 /// A protobuf message which contains all scalar types.
 #[allow(clippy::derive_partial_eq_without_eq)]
 #[derive(Clone, PartialEq, Message)]
@@ -403,3 +427,180 @@ pub enum BasicOneof {
     #[prost(string, tag = "9")]
     String(String),
 }
+
+#[derive(Clone, PartialEq, Message)]
+pub struct CachedLeaf {
+    #[prost(string, tag = "1")]
+    pub name: String,
+    #[prost(int64, repeated, tag = "2")]
+    pub values: Vec<i64>,
+    #[prost(cached_size)]
+    pub cached_size: prost::CachedSize,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct CachedNode {
+    #[prost(message, repeated, tag = "1")]
+    pub children: Vec<CachedNode>,
+    #[prost(message, optional, tag = "2")]
+    pub leaf: Option<CachedLeaf>,
+    #[prost(cached_size)]
+    pub cached_size: prost::CachedSize,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct UncachedLeaf {
+    #[prost(string, tag = "1")]
+    pub name: String,
+    #[prost(int64, repeated, tag = "2")]
+    pub values: Vec<i64>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct UncachedNode {
+    #[prost(message, repeated, tag = "1")]
+    pub children: Vec<UncachedNode>,
+    #[prost(message, optional, tag = "2")]
+    pub leaf: Option<UncachedLeaf>,
+}
+
+#[test]
+fn check_cached_size() {
+    fn tree(depth: usize) -> UncachedNode {
+        UncachedNode {
+            children: if depth == 0 {
+                Vec::new()
+            } else {
+                vec![tree(depth - 1), tree(depth - 1)]
+            },
+            leaf: Some(UncachedLeaf {
+                name: "leaf".repeat(depth),
+                values: (0..depth as i64 * 40).collect(),
+            }),
+        }
+    }
+
+    let uncached = tree(4);
+    let encoded = uncached.encode_to_vec();
+    let mut cached = CachedNode::decode(encoded.as_slice()).unwrap();
+    assert_eq!(cached.encoded_len(), encoded.len());
+    assert_eq!(cached.encode_to_vec(), encoded);
+    assert_eq!(
+        cached.encode_length_delimited_to_vec(),
+        uncached.encode_length_delimited_to_vec()
+    );
+
+    // Modifying the message must not encode stale lengths.
+    cached.children[0]
+        .leaf
+        .as_mut()
+        .unwrap()
+        .name
+        .push_str("longer");
+    let decoded = UncachedNode::decode(cached.encode_to_vec().as_slice()).unwrap();
+    assert_eq!(
+        decoded.children[0].leaf.as_ref().unwrap().name,
+        "leafleafleaflonger"
+    );
+    assert_eq!(cached.encoded_len(), cached.encode_to_vec().len());
+}
+
+#[test]
+fn check_repeated_reservation_bounded_by_message() {
+    // A child with a single grandchild, followed by many empty siblings. The siblings have the
+    // same key as the grandchild, but must not be reserved for in the child's repeated field.
+    let mut encoded = vec![0x0a, 0x02, 0x0a, 0x00];
+    for _ in 0..1000 {
+        encoded.extend_from_slice(&[0x0a, 0x00]);
+    }
+    let decoded = UncachedNode::decode(encoded.as_slice()).unwrap();
+    assert_eq!(decoded.children.len(), 1001);
+    assert_eq!(decoded.children[0].children.len(), 1);
+    assert!(decoded.children[0].children.capacity() < 16);
+    assert_eq!(decoded.children[1].children.capacity(), 0);
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct FieldOrder {
+    #[prost(int32, tag = "1")]
+    pub int32: i32,
+    #[prost(int64, repeated, packed = "false", tag = "2")]
+    pub unpacked: Vec<i64>,
+    #[prost(string, repeated, tag = "3")]
+    pub strings: Vec<String>,
+    #[prost(fixed64, tag = "200")]
+    pub two_byte_key: u64,
+    #[prost(message, optional, tag = "201")]
+    pub message: Option<UncachedLeaf>,
+    #[prost(double, tag = "3000")]
+    pub three_byte_key: f64,
+}
+
+#[test]
+fn check_field_order() {
+    let message = FieldOrder {
+        int32: 5,
+        unpacked: vec![1, -2, 3],
+        strings: vec!["a".to_owned(), String::new(), "c".to_owned()],
+        two_byte_key: 7,
+        message: Some(UncachedLeaf {
+            name: "leaf".to_owned(),
+            values: vec![1, 2],
+        }),
+        three_byte_key: 1.5,
+    };
+    let encoded = message.encode_to_vec();
+    assert_eq!(FieldOrder::decode(encoded.as_slice()).unwrap(), message);
+
+    // Encode each field separately, and concatenate them in reverse tag order.
+    let fields = [
+        FieldOrder {
+            int32: message.int32,
+            ..Default::default()
+        },
+        FieldOrder {
+            unpacked: message.unpacked.clone(),
+            ..Default::default()
+        },
+        FieldOrder {
+            strings: message.strings.clone(),
+            ..Default::default()
+        },
+        FieldOrder {
+            two_byte_key: message.two_byte_key,
+            ..Default::default()
+        },
+        FieldOrder {
+            message: message.message.clone(),
+            ..Default::default()
+        },
+        FieldOrder {
+            three_byte_key: message.three_byte_key,
+            ..Default::default()
+        },
+    ];
+    let mut reversed = Vec::new();
+    for field in fields.iter().rev() {
+        field.encode(&mut reversed).unwrap();
+    }
+    assert_eq!(reversed.len(), encoded.len());
+    assert_ne!(reversed, encoded);
+    assert_eq!(FieldOrder::decode(reversed.as_slice()).unwrap(), message);
+
+    // Unknown fields, and known fields with the wrong wire type, interrupt the expected order.
+    let mut interrupted = encoded.clone();
+    interrupted.splice(0..0, [0x20, 0x01, 0x0a, 0x00]);
+    assert!(FieldOrder::decode(interrupted.as_slice()).is_err());
+    interrupted.drain(2..4);
+    assert_eq!(FieldOrder::decode(interrupted.as_slice()).unwrap(), message);
+
+    // Nested and length-delimited messages use the same decoding loop.
+    let mut nested = Vec::new();
+    message.encode_length_delimited(&mut nested).unwrap();
+    assert_eq!(
+        FieldOrder::decode_length_delimited(nested.as_slice()).unwrap(),
+        message
+    );
+    nested[0] -= 1;
+    assert!(FieldOrder::decode_length_delimited(nested.as_slice()).is_err());
+}
@@ -0,0 +1,73 @@
+use prost::alloc::vec;
+#[cfg(not(feature = "std"))]
+use prost::alloc::{borrow::ToOwned, boxed::Box, string::String, string::ToString, vec::Vec};
+
+use prost::{Message, MessageView};
+
+include!(concat!(env!("OUT_DIR"), "/message_view.rs"));
+
+#[test]
+fn decode_message_view() {
+    let mut envelope = Envelope {
+        headers: vec![
+            Header {
+                key: "content-type".to_string(),
+                value: b"proto".to_vec(),
+            },
+            Header {
+                key: "empty".to_string(),
+                value: Vec::new(),
+            },
+        ],
+        route: "ingest".to_string(),
+        trace: Some(String::new()),
+        tags: vec!["a".to_string(), "b".to_string()],
+        payload: Some(Payload { id: 42 }),
+        parent: Some(Box::new(Envelope {
+            route: "parent".to_owned(),
+            ..Default::default()
+        })),
+        sequence: vec![1, -1, 300],
+        metadata: Default::default(),
+        body: Some(envelope::Body::Text("body".to_string())),
+    };
+    envelope
+        .metadata
+        .insert("key".to_string(), "value".to_string());
+    let encoded = envelope.encode_to_vec();
+
+    let view = EnvelopeView::decode(&encoded).unwrap();
+    assert_eq!(view.headers.len(), 2);
+    assert_eq!(view.headers[0].key, "content-type");
+    assert_eq!(view.headers[0].value, b"proto");
+    assert_eq!(view.headers[1].value, b"");
+    assert_eq!(view.route, "ingest");
+    assert_eq!(view.trace, Some(""));
+    assert_eq!(view.tags, ["a", "b"]);
+    assert_eq!(view.parent.as_ref().unwrap().route, "parent");
+    assert_eq!(view.sequence, [1, -1, 300]);
+
+    // Payload has no view of its own, so it is kept in its encoded form.
+    assert_eq!(Payload::decode(view.payload.unwrap()).unwrap().id, 42);
+
+    // Fields borrow from the input buffer.
+    let range = encoded.as_ptr_range();
+    assert!(range.contains(&view.route.as_ptr()));
+    assert!(range.contains(&view.headers[0].value.as_ptr()));
+
+    let delimited = envelope.encode_length_delimited_to_vec();
+    assert_eq!(
+        EnvelopeView::decode_length_delimited(&delimited).unwrap(),
+        view
+    );
+}
+
+#[test]
+fn decode_message_view_invalid() {
+    // Invalid UTF-8 in a string field.
+    assert!(HeaderView::decode(&[0x0a, 0x02, 0xff, 0xfe]).is_err());
+    // Length prefix past the end of the buffer.
+    assert!(HeaderView::decode(&[0x12, 0x05, 0x61]).is_err());
+    // Wrong wire type.
+    assert!(HeaderView::decode(&[0x08, 0x01]).is_err());
+}
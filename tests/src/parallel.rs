@@ -0,0 +1,165 @@
+use prost::{merge_repeated_parallel, with_interner, Interned, Message, StringInterner};
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Batch {
+    #[prost(string, tag = "1")]
+    pub source: String,
+    #[prost(message, repeated, tag = "2")]
+    pub records: Vec<Record>,
+    #[prost(uint64, repeated, tag = "3")]
+    pub sizes: Vec<u64>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Record {
+    #[prost(uint64, tag = "1")]
+    pub id: u64,
+    #[prost(string, tag = "2")]
+    pub name: String,
+    #[prost(message, optional, tag = "3")]
+    pub parent: Option<Box<Record>>,
+}
+
+fn batch(len: u64) -> Batch {
+    Batch {
+        source: "parallel".to_owned(),
+        records: (0..len)
+            .map(|id| Record {
+                id,
+                name: format!("record {}", id),
+                parent: (id % 3 == 0).then(|| Box::new(Record::default())),
+            })
+            .collect(),
+        sizes: (0..len).step_by(1000).collect(),
+    }
+}
+
+fn merge_parallel(batch: &mut Batch, buf: &[u8]) -> Result<(), prost::DecodeError> {
+    merge_repeated_parallel(batch, buf, 2, |batch| &mut batch.records)
+}
+
+#[test]
+fn merge_repeated_parallel_matches_merge() {
+    for len in [0, 1, 10, 100_000] {
+        let encoded = batch(len).encode_to_vec();
+        let mut decoded = Batch::default();
+        merge_parallel(&mut decoded, &encoded).unwrap();
+        assert_eq!(decoded, batch(len));
+    }
+}
+
+#[test]
+fn merge_repeated_parallel_interleaved() {
+    // Elements of the repeated field are appended to the existing ones in their encoded order,
+    // even when other fields are encoded between them.
+    let mut encoded = Vec::new();
+    for chunk in batch(50_000).records.chunks(7000) {
+        Batch {
+            records: chunk.to_vec(),
+            sizes: vec![chunk.len() as u64],
+            ..Batch::default()
+        }
+        .encode(&mut encoded)
+        .unwrap();
+    }
+
+    let mut expected = batch(10);
+    expected.merge(&encoded[..]).unwrap();
+    let mut decoded = batch(10);
+    merge_parallel(&mut decoded, &encoded).unwrap();
+    assert_eq!(decoded, expected);
+}
+
+#[test]
+fn merge_repeated_parallel_invalid() {
+    let mut encoded = batch(100_000).encode_to_vec();
+    // Corrupt the wire type of a field of the last record.
+    let index = encoded.len() - 5;
+    let position = encoded[..index]
+        .iter()
+        .rposition(|&byte| byte == 0x08)
+        .unwrap();
+    encoded[position] = 0x0b;
+
+    let mut decoded = batch(1);
+    let error = merge_parallel(&mut decoded, &encoded).unwrap_err();
+    assert!(error.to_string().contains("invalid wire type"), "{}", error);
+    // Unlike `Message::merge`, the error does not name the repeated field.
+    let merge_error = Batch::decode(&encoded[..]).unwrap_err();
+    assert!(merge_error.to_string().contains("Batch.records: "));
+    assert!(!error.to_string().contains("Batch.records: "));
+    // No elements are added on error.
+    assert_eq!(decoded.records, batch(1).records);
+
+    let error = merge_parallel(&mut Batch::default(), &[0x12, 0x05, 0x08][..]).unwrap_err();
+    assert_eq!(
+        error.to_string(),
+        "failed to decode Protobuf message: buffer underflow"
+    );
+}
+
+#[test]
+fn merge_repeated_parallel_recursion_limit() {
+    // Elements are decoded at the same depth as with `Message::merge`.
+    for depth in 95..105 {
+        let mut record = Record::default();
+        for _ in 0..depth {
+            record = Record {
+                parent: Some(Box::new(record)),
+                ..Record::default()
+            };
+        }
+        let mut encoded = batch(100_000).encode_to_vec();
+        Batch {
+            records: vec![record],
+            ..Batch::default()
+        }
+        .encode(&mut encoded)
+        .unwrap();
+
+        let expected = Batch::decode(&encoded[..]).is_ok();
+        assert_eq!(
+            merge_parallel(&mut Batch::default(), &encoded).is_ok(),
+            expected
+        );
+    }
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Labels {
+    #[prost(message, repeated, tag = "1")]
+    pub labels: Vec<Label>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Label {
+    #[prost(string, tag = "1")]
+    pub key: Interned,
+    #[prost(string, tag = "2")]
+    pub value: String,
+}
+
+#[test]
+fn merge_repeated_parallel_with_interner() {
+    // The interner of the current thread is used for every element.
+    let labels = Labels {
+        labels: (0..100_000)
+            .map(|i| Label {
+                key: format!("key {}", i % 10).into(),
+                value: format!("value {}", i),
+            })
+            .collect(),
+    };
+    let encoded = labels.encode_to_vec();
+
+    let mut interner = StringInterner::new();
+    let mut decoded = Labels::default();
+    with_interner(&mut interner, || {
+        merge_repeated_parallel(&mut decoded, &encoded, 1, |labels| &mut labels.labels)
+    })
+    .unwrap();
+    assert_eq!(decoded, labels);
+    assert_eq!(interner.len(), 10);
+    let (first, last) = (&decoded.labels[0], &decoded.labels[99_990]);
+    assert!(Interned::ptr_eq(&first.key, &last.key));
+}
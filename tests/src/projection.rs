@@ -0,0 +1,151 @@
+use prost::{Message, Projection};
+
+include!(concat!(env!("OUT_DIR"), "/projection.rs"));
+
+fn source(host: &str, port: u32) -> Source {
+    Source {
+        host: Some(host.to_string()),
+        port: Some(port),
+    }
+}
+
+fn event() -> Event {
+    Event {
+        name: Some("login".to_string()),
+        source: Some(source("example.com", 443)),
+        hops: vec![source("a", 1), source("b", 2)],
+        payload: Some(vec![1; 100]),
+        labels: [("key".to_string(), "value".to_string())]
+            .into_iter()
+            .collect(),
+        value: Some(event::Value::Number(7)),
+        extra: Some(event::Extra {
+            note: Some("note".to_string()),
+            priority: Some(1),
+        }),
+        parent: Some(Box::new(Event {
+            name: Some("parent".to_string()),
+            source: Some(source("parent.com", 80)),
+            ..Event::default()
+        })),
+        display_name: Some("Login".to_string()),
+    }
+}
+
+fn decode(paths: &[&str]) -> Event {
+    let projection = Projection::from_field_paths::<Event, _>(paths).unwrap();
+    Event::decode_projected(&*event().encode_to_vec(), &projection).unwrap()
+}
+
+#[test]
+fn projection_top_level_fields() {
+    assert_eq!(
+        decode(&["name", "payload"]),
+        Event {
+            name: Some("login".to_string()),
+            payload: Some(vec![1; 100]),
+            ..Event::default()
+        }
+    );
+    assert_eq!(
+        decode(&["labels", "source"]),
+        Event {
+            source: Some(source("example.com", 443)),
+            labels: event().labels,
+            ..Event::default()
+        }
+    );
+}
+
+#[test]
+fn projection_proto_field_names() {
+    // Fields are named as in the `.proto` file, rather than as in the generated struct.
+    assert_eq!(
+        decode(&["displayName"]),
+        Event {
+            display_name: Some("Login".to_string()),
+            ..Event::default()
+        }
+    );
+    assert!(Projection::from_field_paths::<Event, _>(["display_name"]).is_err());
+}
+
+#[test]
+fn projection_nested_fields() {
+    let port = |port| Source {
+        host: None,
+        port: Some(port),
+    };
+    assert_eq!(
+        decode(&[
+            "source.port",
+            "hops.port",
+            "extra.note",
+            "parent.source.host"
+        ]),
+        Event {
+            source: Some(port(443)),
+            hops: vec![port(1), port(2)],
+            extra: Some(event::Extra {
+                note: Some("note".to_string()),
+                priority: None,
+            }),
+            parent: Some(Box::new(Event {
+                source: Some(Source {
+                    host: Some("parent.com".to_string()),
+                    port: None,
+                }),
+                ..Event::default()
+            })),
+            ..Event::default()
+        }
+    );
+
+    // Selecting a message field completely overrides the selection of its fields.
+    assert_eq!(decode(&["source.port", "source"]).source, event().source);
+    assert_eq!(decode(&["source", "source.port"]).source, event().source);
+}
+
+#[test]
+fn projection_by_tags() {
+    // Oneof fields can only be selected by tag.
+    let projection = Projection::new([&[1][..], &[7], &[11, 1]]);
+    let decoded = Event::decode_projected(&*event().encode_to_vec(), &projection).unwrap();
+    assert_eq!(
+        decoded,
+        Event {
+            name: Some("login".to_string()),
+            value: Some(event::Value::Number(7)),
+            parent: Some(Box::new(Event {
+                name: Some("parent".to_string()),
+                ..Event::default()
+            })),
+            ..Event::default()
+        }
+    );
+
+    // An empty path selects everything.
+    let projection = Projection::new([&[1][..], &[]]);
+    let decoded = Event::decode_projected(&*event().encode_to_vec(), &projection).unwrap();
+    assert_eq!(decoded, event());
+}
+
+#[test]
+fn projection_invalid_paths() {
+    for path in [
+        "missing",
+        "name.length",
+        "labels.key",
+        "source.missing",
+        "number",
+        "",
+        "name.",
+    ] {
+        assert_eq!(
+            Projection::from_field_paths::<Event, _>([path])
+                .unwrap_err()
+                .to_string(),
+            "failed to decode Protobuf message: invalid field path: ".to_owned() + path
+        );
+    }
+}
@@ -0,0 +1,144 @@
+use prost::alloc::vec;
+#[cfg(not(feature = "std"))]
+use prost::alloc::{borrow::ToOwned, boxed::Box, string::String, vec::Vec};
+
+use prost::Message;
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Batch {
+    #[prost(string, tag = "1")]
+    pub name: String,
+    #[prost(message, repeated, tag = "2")]
+    pub items: Vec<Item>,
+    #[prost(message, optional, tag = "3")]
+    pub header: Option<Box<Item>>,
+    #[prost(message, required, tag = "4")]
+    pub footer: Item,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Item {
+    #[prost(string, tag = "1")]
+    pub key: String,
+    #[prost(bytes = "vec", tag = "2")]
+    pub value: Vec<u8>,
+    #[prost(uint32, repeated, tag = "3")]
+    pub counts: Vec<u32>,
+    #[prost(message, repeated, tag = "4")]
+    pub children: Vec<Item>,
+}
+
+fn item(key: &str, len: usize) -> Item {
+    Item {
+        key: key.to_owned(),
+        value: vec![7; len],
+        counts: (0..len as u32).collect(),
+        children: vec![Item {
+            key: key.to_owned() + "/child",
+            ..Item::default()
+        }],
+    }
+}
+
+/// Checks that `decode_reusing` gives the same result as decoding into a new message.
+fn check_decode_reusing(message: &mut Batch, expected: &Batch) {
+    message.decode_reusing(&expected.encode_to_vec()[..]).unwrap();
+    assert_eq!(message, expected);
+}
+
+#[test]
+fn decode_reusing_matches_decode() {
+    let batches = [
+        Batch {
+            name: "large".to_owned(),
+            items: vec![item("a", 100), item("b", 200), item("c", 300)],
+            header: Some(Box::new(item("header", 10))),
+            footer: item("footer", 10),
+        },
+        Batch {
+            name: "small".to_owned(),
+            items: vec![item("d", 1)],
+            header: None,
+            footer: Item::default(),
+        },
+        Batch::default(),
+        Batch {
+            name: "larger".to_owned(),
+            items: vec![item("e", 10), item("f", 20), item("g", 30), item("h", 40)],
+            header: Some(Box::new(Item::default())),
+            footer: item("footer", 1),
+        },
+    ];
+
+    let mut message = Batch::default();
+    for batch in &batches {
+        check_decode_reusing(&mut message, batch);
+    }
+}
+
+#[test]
+fn decode_reusing_keeps_allocations() {
+    let mut message = Batch::default();
+    check_decode_reusing(
+        &mut message,
+        &Batch {
+            name: "first".to_owned(),
+            items: vec![item("a", 100), item("b", 100)],
+            header: Some(Box::new(item("header", 100))),
+            footer: item("footer", 100),
+        },
+    );
+    let items = message.items.as_ptr();
+    let value = message.items[1].value.as_ptr();
+    let header = message.header.as_deref().unwrap() as *const Item;
+    let footer = message.footer.counts.as_ptr();
+
+    check_decode_reusing(
+        &mut message,
+        &Batch {
+            name: "second".to_owned(),
+            items: vec![item("c", 50), item("d", 50)],
+            header: Some(Box::new(item("header", 50))),
+            footer: item("footer", 50),
+        },
+    );
+    assert_eq!(message.items.as_ptr(), items);
+    assert_eq!(message.items[1].value.as_ptr(), value);
+    assert_eq!(message.header.as_deref().unwrap() as *const Item, header);
+    assert_eq!(message.footer.counts.as_ptr(), footer);
+}
+
+#[test]
+fn decode_reusing_merges_repeated_singular_fields() {
+    // A singular message field which is encoded twice is merged, as with `decode`.
+    let first = Batch {
+        header: Some(Box::new(item("first", 1))),
+        ..Batch::default()
+    };
+    let second = Batch {
+        header: Some(Box::new(Item {
+            counts: vec![5],
+            ..Item::default()
+        })),
+        ..Batch::default()
+    };
+    let mut buf = first.encode_to_vec();
+    second.encode(&mut buf).unwrap();
+
+    let mut message = Batch {
+        header: Some(Box::new(item("stale", 10))),
+        ..Batch::default()
+    };
+    message.decode_reusing(&buf[..]).unwrap();
+    assert_eq!(message, Batch::decode(&buf[..]).unwrap());
+}
+
+#[test]
+fn decode_reusing_invalid() {
+    let mut message = Batch::default();
+    let error = message.decode_reusing(&[0x12, 0x05, 0x0a][..]).unwrap_err();
+    assert_eq!(
+        error.to_string(),
+        "failed to decode Protobuf message: Batch.items: buffer underflow"
+    );
+}
@@ -0,0 +1,99 @@
+use prost::alloc::collections::BTreeMap;
+use prost::alloc::vec;
+#[cfg(not(feature = "std"))]
+use prost::alloc::{boxed::Box, string::String, string::ToString, vec::Vec};
+
+use prost::{Message, Oneof, ReverseBuf};
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Tree {
+    #[prost(string, tag = "1")]
+    pub name: String,
+    #[prost(sint64, optional, tag = "2")]
+    pub weight: Option<i64>,
+    #[prost(message, repeated, tag = "3")]
+    pub children: Vec<Tree>,
+    #[prost(message, optional, boxed, tag = "4")]
+    pub parent: Option<Box<Tree>>,
+    #[prost(fixed32, repeated, tag = "5")]
+    pub values: Vec<u32>,
+    #[prost(btree_map = "string, message", tag = "6")]
+    pub attributes: BTreeMap<String, Tree>,
+    #[prost(oneof = "Data", tags = "7, 8")]
+    pub data: Option<Data>,
+    #[prost(message, required, tag = "9")]
+    pub info: Info,
+}
+
+#[derive(Clone, PartialEq, Oneof)]
+pub enum Data {
+    #[prost(bytes, tag = "7")]
+    Raw(Vec<u8>),
+    #[prost(message, tag = "8")]
+    Info(Info),
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Info {
+    #[prost(string, tag = "1")]
+    pub text: String,
+}
+
+fn tree(depth: u32) -> Tree {
+    Tree {
+        name: "node".repeat(depth as usize),
+        weight: Some(-(depth as i64)),
+        children: if depth == 0 {
+            Vec::new()
+        } else {
+            vec![tree(depth - 1), Tree::default(), tree(depth - 1)]
+        },
+        parent: Some(Box::new(Tree {
+            name: "parent".to_string(),
+            ..Tree::default()
+        })),
+        values: vec![depth; depth as usize],
+        attributes: [("key".to_string(), Tree::default())].into_iter().collect(),
+        data: Some(if depth % 2 == 0 {
+            Data::Raw(vec![1; 200])
+        } else {
+            Data::Info(Info {
+                text: "info".to_string(),
+            })
+        }),
+        info: Info {
+            text: "x".repeat(300),
+        },
+    }
+}
+
+#[test]
+fn encode_reverse_matches_encode() {
+    for depth in 0..5 {
+        let tree = tree(depth);
+        let mut buf = ReverseBuf::new();
+        tree.encode_reverse(&mut buf);
+        assert_eq!(buf.as_slice(), tree.encode_to_vec());
+        assert_eq!(buf.into_vec(), tree.encode_to_vec());
+    }
+}
+
+#[test]
+fn encode_reverse_prepends() {
+    let first = tree(2);
+    let second = tree(1);
+
+    // Messages are written in front of the bytes already in the buffer.
+    let mut buf = ReverseBuf::with_capacity(16);
+    second.encode_reverse(&mut buf);
+    first.encode_reverse(&mut buf);
+
+    let mut expected = first.encode_to_vec();
+    expected.extend(second.encode_to_vec());
+    assert_eq!(buf.as_slice(), expected);
+
+    buf.clear();
+    assert!(buf.is_empty());
+    Tree::default().encode_reverse(&mut buf);
+    assert_eq!(buf.as_slice(), Tree::default().encode_to_vec());
+}
@@ -0,0 +1,113 @@
+use prost::alloc::vec;
+#[cfg(not(feature = "std"))]
+use prost::alloc::{borrow::ToOwned, boxed::Box, string::String, vec::Vec};
+
+use prost::{Message, StreamDecoder};
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Chunk {
+    #[prost(uint64, tag = "1")]
+    pub id: u64,
+    #[prost(string, tag = "2")]
+    pub name: String,
+    #[prost(bytes = "vec", repeated, tag = "3")]
+    pub data: Vec<Vec<u8>>,
+    #[prost(fixed32, tag = "4")]
+    pub checksum: u32,
+    #[prost(double, repeated, tag = "5")]
+    pub values: Vec<f64>,
+    #[prost(message, optional, tag = "6")]
+    pub next: Option<Box<Chunk>>,
+}
+
+fn chunks() -> Vec<Chunk> {
+    vec![
+        Chunk {
+            id: 1,
+            name: "first".to_owned(),
+            data: vec![vec![1; 300], vec![]],
+            checksum: 0xdead_beef,
+            values: vec![0.5, -1.0],
+            next: Some(Box::new(Chunk {
+                id: 2,
+                ..Default::default()
+            })),
+        },
+        Chunk::default(),
+        Chunk {
+            id: u64::MAX,
+            name: "last".to_owned(),
+            ..Default::default()
+        },
+    ]
+}
+
+#[test]
+fn stream_decoder_chunk_sizes() {
+    let chunks = chunks();
+    let mut encoded = Vec::new();
+    for chunk in &chunks {
+        chunk.encode_length_delimited(&mut encoded).unwrap();
+    }
+
+    for size in [1, 2, 3, 7, 64, encoded.len()] {
+        let mut decoder = StreamDecoder::<Chunk>::new(1024);
+        let mut decoded = Vec::new();
+        for piece in encoded.chunks(size) {
+            decoder.push(piece);
+            while let Some(chunk) = decoder.next_message().unwrap() {
+                decoded.push(chunk);
+            }
+        }
+        assert_eq!(decoded, chunks, "chunk size {}", size);
+        assert!(decoder.is_empty());
+    }
+}
+
+#[test]
+fn stream_decoder_partial() {
+    let mut encoded = Vec::new();
+    chunks()[0].encode_length_delimited(&mut encoded).unwrap();
+
+    let mut decoder = StreamDecoder::<Chunk>::new(1024);
+    decoder.push(&encoded[..encoded.len() - 1]);
+    assert_eq!(decoder.next_message().unwrap(), None);
+    assert!(!decoder.is_empty());
+    decoder.push(&encoded[encoded.len() - 1..]);
+    assert_eq!(decoder.next_message().unwrap(), Some(chunks()[0].clone()));
+    assert_eq!(decoder.next_message().unwrap(), None);
+}
+
+#[test]
+fn stream_decoder_max_frame_len() {
+    let chunk = chunks().remove(0);
+    let mut encoded = Vec::new();
+    chunk.encode_length_delimited(&mut encoded).unwrap();
+
+    let mut decoder = StreamDecoder::<Chunk>::new(chunk.encoded_len());
+    decoder.push(&encoded);
+    assert_eq!(decoder.next_message().unwrap(), Some(chunk.clone()));
+
+    // The frame is rejected before its body arrives.
+    let mut decoder = StreamDecoder::<Chunk>::new(chunk.encoded_len() - 1);
+    decoder.push(&encoded[..2]);
+    assert!(decoder.next_message().is_err());
+}
+
+#[test]
+fn stream_decoder_invalid() {
+    // A field which extends past the end of its message.
+    let mut decoder = StreamDecoder::<Chunk>::new(1024);
+    decoder.push(b"\x03\x12\x05abc");
+    assert!(decoder.next_message().is_err());
+
+    // A truncated varint at the end of a message.
+    let mut decoder = StreamDecoder::<Chunk>::new(1024);
+    decoder.push(b"\x02\x08\x80\x01");
+    assert!(decoder.next_message().is_err());
+
+    // A field with the wrong wire type.
+    let mut decoder = StreamDecoder::<Chunk>::new(1024);
+    decoder.push(b"\x02\x10\x01");
+    assert!(decoder.next_message().is_err());
+}
@@ -0,0 +1,207 @@
+use prost::alloc::sync::Arc;
+use prost::alloc::vec;
+#[cfg(not(feature = "std"))]
+use prost::alloc::{
+    boxed::Box,
+    format,
+    string::{String, ToString},
+    vec::Vec,
+};
+
+use prost::bytes::{Buf, BufMut};
+use prost::encoding::{BytesAdapter, DecodeContext, StringAdapter, WireType};
+use prost::Message;
+
+include!(concat!(env!("OUT_DIR"), "/string_type.rs"));
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Boxed {
+    #[prost(string, tag = "1")]
+    pub name: Box<str>,
+    #[prost(string, repeated, tag = "2")]
+    pub tags: Vec<Box<str>>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Owned {
+    #[prost(string, tag = "1")]
+    pub name: String,
+    #[prost(string, repeated, tag = "2")]
+    pub tags: Vec<String>,
+}
+
+/// A string which stores values of up to 22 bytes inline, without a heap allocation.
+#[derive(Clone, Debug, PartialEq)]
+pub enum InlineString {
+    Inline(u8, [u8; 22]),
+    Heap(String),
+}
+
+impl Default for InlineString {
+    fn default() -> InlineString {
+        InlineString::Inline(0, [0; 22])
+    }
+}
+
+impl StringAdapter for InlineString {
+    fn as_str(&self) -> &str {
+        match self {
+            InlineString::Inline(len, bytes) => {
+                core::str::from_utf8(&bytes[..*len as usize]).unwrap()
+            }
+            InlineString::Heap(value) => value,
+        }
+    }
+
+    fn replace_with(&mut self, value: &str) {
+        *self = match value.len() {
+            len @ 0..=22 => {
+                let mut bytes = [0; 22];
+                bytes[..len].copy_from_slice(value.as_bytes());
+                InlineString::Inline(len as u8, bytes)
+            }
+            _ => InlineString::Heap(value.into()),
+        };
+    }
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Inline {
+    #[prost(string, tag = "1")]
+    pub name: InlineString,
+    #[prost(string, repeated, tag = "2")]
+    pub tags: Vec<InlineString>,
+}
+
+/// A bytes buffer which stores values of up to 22 bytes inline.
+#[derive(Clone, Debug, PartialEq)]
+pub struct InlineBytes(u8, [u8; 22], Vec<u8>);
+
+impl Default for InlineBytes {
+    fn default() -> InlineBytes {
+        InlineBytes(0, [0; 22], Vec::new())
+    }
+}
+
+impl InlineBytes {
+    fn as_slice(&self) -> &[u8] {
+        match self.0 {
+            0 => &self.2,
+            len => &self.1[..len as usize],
+        }
+    }
+}
+
+impl BytesAdapter for InlineBytes {
+    fn len(&self) -> usize {
+        self.as_slice().len()
+    }
+
+    fn replace_with(&mut self, mut buf: impl Buf) {
+        let len = buf.remaining();
+        *self = InlineBytes::default();
+        if (1..=22).contains(&len) {
+            self.0 = len as u8;
+            buf.copy_to_slice(&mut self.1[..len]);
+        } else {
+            self.2.put(buf);
+        }
+    }
+
+    fn append_to(&self, buf: &mut impl BufMut) {
+        buf.put_slice(self.as_slice())
+    }
+}
+
+#[test]
+fn string_type_roundtrip() {
+    let name: Arc<str> = "name".into();
+    let shared = Shared {
+        name: Some(name.clone()),
+        label: None,
+        tags: vec![name.clone(), "".into()],
+        attributes: [("key".into(), "value".into())].into_iter().collect(),
+        value: Some(shared::Value::Text(name.clone())),
+        id: "id".into(),
+    };
+    let encoded = shared.encode_to_vec();
+    let decoded = Shared::decode(&encoded[..]).unwrap();
+    assert_eq!(decoded, shared);
+    assert_eq!(decoded.label(), "none");
+    assert_eq!(Shared::default().label(), "none");
+    assert!(format!("{:?}", decoded).contains("tags: [\"name\", \"\"]"));
+
+    // Cloning a message shares its strings.
+    let cloned = shared.clone();
+    assert!(Arc::ptr_eq(cloned.name.as_ref().unwrap(), &name));
+}
+
+#[test]
+fn string_type_compatible_with_string() {
+    let boxed = Boxed {
+        name: "boxed".into(),
+        tags: vec!["a".into(), "".into(), "b".into()],
+    };
+    let encoded = boxed.encode_to_vec();
+    assert_eq!(boxed.encoded_len(), encoded.len());
+
+    let owned = Owned::decode(&encoded[..]).unwrap();
+    assert_eq!(&*owned.name, "boxed");
+    assert_eq!(owned.tags, ["a", "", "b"]);
+    assert_eq!(owned.encode_to_vec(), encoded);
+    assert_eq!(Boxed::decode(&encoded[..]).unwrap(), boxed);
+
+    // An empty string is not encoded.
+    assert!(Boxed::default().encode_to_vec().is_empty());
+}
+
+#[test]
+fn string_type_invalid_utf8() {
+    let mut boxed = Boxed {
+        name: "boxed".into(),
+        ..Boxed::default()
+    };
+    let error = boxed.merge(&[0x0a, 0x02, 0xc3, 0x28][..]).unwrap_err();
+    assert_eq!(
+        error.to_string(),
+        "failed to decode Protobuf message: Boxed.name: invalid string value: data is not UTF-8 encoded"
+    );
+    assert_eq!(&*boxed.name, "");
+}
+
+#[test]
+fn string_type_custom_adapter() {
+    let inline = Inline {
+        name: InlineString::default(),
+        tags: ["short", "a value which is too long to be stored inline"]
+            .iter()
+            .map(|tag| {
+                let mut value = InlineString::default();
+                value.replace_with(tag);
+                value
+            })
+            .collect(),
+    };
+    let encoded = inline.encode_to_vec();
+    let decoded = Inline::decode(&encoded[..]).unwrap();
+    assert_eq!(decoded, inline);
+    assert!(matches!(decoded.tags[0], InlineString::Inline(5, _)));
+    assert!(matches!(decoded.tags[1], InlineString::Heap(_)));
+    assert_eq!(Owned::decode(&encoded[..]).unwrap().tags[0], "short");
+
+    for value in [&b"bytes"[..], &[7; 100][..]] {
+        let mut encoded = Vec::new();
+        prost::encoding::bytes::encode(1, &value.to_vec(), &mut encoded);
+        let mut decoded = InlineBytes::default();
+        let mut buf = &encoded[1..];
+        prost::encoding::bytes::merge(
+            WireType::LengthDelimited,
+            &mut decoded,
+            &mut buf,
+            DecodeContext::default(),
+        )
+        .unwrap();
+        assert_eq!(decoded.as_slice(), value);
+        assert_eq!(decoded.0 != 0, value.len() <= 22);
+    }
+}
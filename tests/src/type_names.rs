@@ -8,14 +8,17 @@ fn valid_type_names() {
     assert_eq!("type_names", Foo::PACKAGE);
     assert_eq!("type_names.Foo", Foo::full_name());
     assert_eq!("tests/type_names.Foo", Foo::type_url());
+    assert_eq!(Some("tests/type_names.Foo"), Foo::TYPE_URL);
 
     assert_eq!("Bar", foo::Bar::NAME);
     assert_eq!("type_names", foo::Bar::PACKAGE);
     assert_eq!("type_names.Foo.Bar", foo::Bar::full_name());
     assert_eq!("tests/type_names.Foo.Bar", foo::Bar::type_url());
+    assert_eq!(Some("tests/type_names.Foo.Bar"), foo::Bar::TYPE_URL);
 
     assert_eq!("Baz", Baz::NAME);
     assert_eq!("type_names", Baz::PACKAGE);
     assert_eq!("type_names.Baz", Baz::full_name());
     assert_eq!("/type_names.Baz", Baz::type_url());
+    assert_eq!(Some("/type_names.Baz"), Baz::TYPE_URL);
 }
@@ -0,0 +1,95 @@
+use prost::alloc::vec;
+#[cfg(not(feature = "std"))]
+use prost::alloc::{boxed::Box, string::ToString};
+
+use prost::bytes::{Buf, Bytes};
+use prost::encoding::WireType;
+use prost::Message;
+
+include!(concat!(env!("OUT_DIR"), "/unknown_fields.rs"));
+
+fn current() -> Current {
+    Current {
+        name: Some("name".to_string()),
+        size: Some(300),
+        checksum: Some(0xdead_beef),
+        timestamp: Some(u64::MAX),
+        data: Some(vec![7; 1000]),
+        extra: Some(current::Extra {
+            note: Some("note".to_string()),
+        }),
+        values: vec![-1, 0, 1],
+        child: Some(Box::new(Current {
+            size: Some(1),
+            ..Current::default()
+        })),
+    }
+}
+
+#[test]
+fn unknown_fields_roundtrip() {
+    let current = current();
+    let encoded = Bytes::from(current.encode_to_vec());
+
+    let legacy = Legacy::decode(encoded.clone()).unwrap();
+    assert_eq!(legacy.name.as_deref(), Some("name"));
+    assert_eq!(legacy._unknown_fields.len(), 6);
+    let child = legacy.child.as_ref().unwrap();
+    assert_eq!(child._unknown_fields.len(), 1);
+
+    let reencoded = legacy.encode_to_vec();
+    assert_eq!(reencoded.len(), encoded.len());
+    assert_eq!(legacy.encoded_len(), encoded.len());
+    assert_eq!(Current::decode(&reencoded[..]).unwrap(), current);
+}
+
+#[test]
+fn unknown_fields_reference_input() {
+    let encoded = Bytes::from(current().encode_to_vec());
+    let legacy = Legacy::decode(encoded.clone()).unwrap();
+
+    let input = encoded.as_ptr_range();
+    let (tag, wire_type, value) = legacy
+        ._unknown_fields
+        .iter()
+        .find(|&(tag, _, _)| tag == 5)
+        .unwrap();
+    assert_eq!((tag, wire_type), (5, WireType::LengthDelimited));
+    // The value includes its two byte length.
+    assert_eq!(value.len(), 1002);
+    assert!(input.contains(&value.as_ptr()));
+}
+
+#[test]
+fn unknown_fields_non_contiguous() {
+    let current = current();
+    let encoded = current.encode_to_vec();
+
+    // Split the input in the middle of the `data` field.
+    for split in [1, 20, 500, encoded.len() - 1] {
+        let (first, second) = encoded.split_at(split);
+        let legacy = Legacy::decode(first.chain(second)).unwrap();
+        assert_eq!(Current::decode(&*legacy.encode_to_vec()).unwrap(), current);
+    }
+}
+
+#[test]
+fn unknown_fields_clear() {
+    let mut legacy = Legacy::decode(&*current().encode_to_vec()).unwrap();
+    assert!(!legacy._unknown_fields.is_empty());
+    assert_ne!(legacy, Legacy::default());
+
+    legacy.clear();
+    assert!(legacy._unknown_fields.is_empty());
+    assert_eq!(legacy, Legacy::default());
+}
+
+#[test]
+fn unknown_fields_invalid() {
+    // An unknown length delimited field which extends past the end of the buffer.
+    let encoded = [0x2a, 0x05, 0x01];
+    assert_eq!(
+        Legacy::decode(&encoded[..]).unwrap_err().to_string(),
+        "failed to decode Protobuf message: buffer underflow"
+    );
+}
@@ -0,0 +1,96 @@
+use prost::alloc::vec;
+#[cfg(not(feature = "std"))]
+use prost::alloc::{borrow::ToOwned, string::String, vec::Vec};
+
+use prost::bytes::Bytes;
+use prost::{Message, VectoredBuf};
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Blobs {
+    #[prost(string, tag = "1")]
+    pub name: String,
+    #[prost(bytes = "bytes", repeated, tag = "2")]
+    pub blobs: Vec<Bytes>,
+    #[prost(bytes = "vec", tag = "3")]
+    pub copied: Vec<u8>,
+    #[prost(message, optional, tag = "4")]
+    pub nested: Option<Nested>,
+}
+
+#[derive(Clone, PartialEq, Message)]
+pub struct Nested {
+    #[prost(bytes = "bytes", tag = "1")]
+    pub blob: Bytes,
+}
+
+fn blobs() -> Blobs {
+    Blobs {
+        name: "blobs".to_owned(),
+        blobs: vec![
+            Bytes::from(vec![1; 10_000]),
+            Bytes::from_static(b"small"),
+            Bytes::from(vec![2; 5_000]),
+        ],
+        copied: vec![3; 10_000],
+        nested: Some(Nested {
+            blob: Bytes::from(vec![4; 8_000]),
+        }),
+    }
+}
+
+#[test]
+fn vectored_encoding() {
+    let blobs = blobs();
+    let mut buf = VectoredBuf::new();
+    blobs.encode(&mut buf).unwrap();
+    assert_eq!(buf.len(), blobs.encoded_len());
+
+    let segments = buf.into_segments();
+    let encoded = segments.concat();
+    assert_eq!(encoded, blobs.encode_to_vec());
+    assert_eq!(Blobs::decode(encoded.as_slice()).unwrap(), blobs);
+
+    // Large `Bytes` values are referenced, not copied.
+    for blob in [&blobs.blobs[0], &blobs.blobs[2], &blobs.nested.unwrap().blob] {
+        assert!(segments
+            .iter()
+            .any(|segment| segment.as_ptr() == blob.as_ptr() && segment.len() == blob.len()));
+    }
+    assert!(segments
+        .iter()
+        .all(|segment| segment.as_ptr() != blobs.copied.as_ptr()));
+}
+
+#[test]
+fn vectored_encoding_min_segment_len() {
+    let blobs = blobs();
+
+    let mut buf = VectoredBuf::with_min_segment_len(usize::MAX);
+    blobs.encode(&mut buf).unwrap();
+    assert_eq!(buf.into_segments(), vec![Bytes::from(blobs.encode_to_vec())]);
+
+    let mut buf = VectoredBuf::with_min_segment_len(1);
+    blobs.encode(&mut buf).unwrap();
+    let segments = buf.into_segments();
+    assert!(segments.iter().any(|segment| segment == "small"));
+
+    assert!(VectoredBuf::new().into_segments().is_empty());
+}
+
+#[cfg(feature = "std")]
+#[test]
+fn vectored_encoding_io_slices() {
+    use std::io::Write;
+
+    let blobs = blobs();
+    let mut buf = VectoredBuf::new();
+    blobs.encode_length_delimited(&mut buf).unwrap();
+
+    let mut written = Vec::new();
+    let slices = buf.io_slices();
+    assert!(slices.len() > 1);
+    for slice in &slices {
+        written.write_all(slice).unwrap();
+    }
+    assert_eq!(written, blobs.encode_length_delimited_to_vec());
+}